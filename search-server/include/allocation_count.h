@@ -0,0 +1,8 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+
+// Количество вызовов глобальных операторов new всех форм с начала работы программы.
+// Подсчёт заменяет глобальные операторы и включается опцией сборки COUNT_ALLOCATIONS;
+// без неё функция возвращает пустое значение
+std::optional<size_t> GetAllocationCount();
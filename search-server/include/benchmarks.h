@@ -6,6 +6,7 @@
 #include <string_view>
 #include <vector>
 
+#include "allocation_count.h"
 #include "search_server.h"
 #include "log_duration.h"
 
@@ -24,6 +25,18 @@ void BenchmarkMatchDocument();
 
 void BenchmarkRemoveDocument();
 
+void BenchmarkAddDocuments();
+
+void BenchmarkSnapshot();
+
+void BenchmarkSearchContext();
+
+void BenchmarkQueryExecutor();
+
+void BenchmarkSegmentedIndex();
+
+void BenchmarkRemoveDuplicates();
+
 template <typename ExecutionPolicy>
 void LogDurationMatchDocument(const std::string& mark, const SearchServer& search_server, const std::string& query, const ExecutionPolicy& policy) {
 
@@ -63,3 +76,12 @@ void LogDurationRemoveDocument(const std::string& mark, SearchServer search_serv
     std::cout << "Result: "s << search_server.GetDocumentCount() << std::endl;
 }
 
+template <typename ExecutionPolicy>
+void LogDurationRemoveDocuments(const std::string& mark, SearchServer search_server, const ExecutionPolicy& policy) {
+    LOG_DURATION(mark + " RemoveDocuments"s);
+
+    const std::vector<int> document_ids(search_server.begin(), search_server.end());
+    search_server.RemoveDocuments(policy, document_ids);
+    std::cout << "Result: "s << search_server.GetDocumentCount() << std::endl;
+}
+
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "document.h"
+#include "segmented_search_server.h"
+
+// Поисковый сервер, который можно изменять под нагрузкой. Индекс хранится в SegmentedSearchServer:
+// читатели получают опубликованный список неизменяемых сегментов одним атомарным чтением указателя
+// и ждут писателя только на время добавления одного документа или пакета в небольшой буфер записи.
+// Писатель не копирует индекс: добавление стоит O(размер документа или пакета), удаление публикует
+// надгробия, а сегменты сливаются в фоне. Писатели выполняются по очереди
+class ConcurrentSearchServer {
+public:
+    template <typename StringContainer>
+    explicit ConcurrentSearchServer(const StringContainer& stop_words,
+                                    size_t write_buffer_size = DEFAULT_WRITE_BUFFER_SIZE,
+                                    size_t merge_factor = DEFAULT_MERGE_FACTOR)
+        : index_(stop_words, write_buffer_size, merge_factor)
+    {
+    }
+
+    explicit ConcurrentSearchServer(const std::string& stop_words_text,
+                                    size_t write_buffer_size = DEFAULT_WRITE_BUFFER_SIZE,
+                                    size_t merge_factor = DEFAULT_MERGE_FACTOR);
+
+    // Запрос выполняется над версией, актуальной в момент вызова; доступны все перегрузки
+    // SegmentedSearchServer, в том числе с политикой выполнения и окном выдачи
+    template <typename... Args>
+    std::vector<Document> FindTopDocuments(Args&&... args) const
+    {
+        return index_.FindTopDocuments(std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    auto MatchDocument(Args&&... args) const
+    {
+        return index_.MatchDocument(std::forward<Args>(args)...);
+    }
+
+    int GetDocumentCount() const;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    // Пакет публикуется целиком: некорректный пакет не изменяет индекс
+    void AddDocuments(const std::vector<DocumentToAdd>& documents);
+
+    void RemoveDocument(int document_id);
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+private:
+    SegmentedSearchServer index_;
+};
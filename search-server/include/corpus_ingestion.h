@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "search_server.h"
+#include "document.h"
+
+// Формат корпуса: один документ на строку, поля разделены табуляцией —
+// id, статус (ACTUAL, IRRELEVANT, BANNED или REMOVED), рейтинги через пробел, текст документа.
+// Пустые строки пропускаются, окончания строк \n и \r\n равноправны
+
+const size_t DEFAULT_CORPUS_CHUNK_SIZE = 16 * 1024 * 1024;
+
+// Разбирает строку корпуса. Текст документа ссылается на память строки
+DocumentToAdd ParseCorpusLine(std::string_view line);
+
+// Читает корпус из файла блоками по chunk_size байт и добавляет документы каждого блока одним пакетом.
+// Текст не копируется: документы пакета ссылаются на буфер чтения, который переиспользуется после
+// индексации пакета, поэтому расход памяти ограничен размером блока (строка длиннее блока его увеличивает).
+// При ошибке в строке пакет с ней не добавляется, ранее добавленные пакеты остаются в сервере.
+// Возвращает количество добавленных документов
+size_t IngestCorpus(SearchServer& search_server, const std::string& path,
+                    size_t chunk_size = DEFAULT_CORPUS_CHUNK_SIZE);
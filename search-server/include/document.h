@@ -1,5 +1,7 @@
 #pragma once
 #include <ostream>
+#include <string_view>
+#include <vector>
 
 enum class DocumentStatus {
     ACTUAL,
@@ -21,3 +23,11 @@ struct Document {
 
 std::ostream& operator<<(std::ostream& out, const Document& doc);
 
+// Документ для пакетного добавления в поисковый сервер
+struct DocumentToAdd {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
+
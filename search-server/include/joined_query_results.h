@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "document.h"
+#include "paginator.h"
+
+// Результаты пакета запросов в одном непрерывном буфере: документы i-го запроса
+// занимают полуинтервал [offsets[i], offsets[i + 1]), порядок запросов сохраняется
+class JoinedQueryResults {
+public:
+    JoinedQueryResults() = default;
+
+    size_t GetQueryCount() const
+    {
+        return offsets_.size() - 1;
+    }
+
+    IteratorRange<std::vector<Document>::const_iterator> GetQueryResults(size_t query_index) const
+    {
+        return {documents_.begin() + offsets_.at(query_index), documents_.begin() + offsets_.at(query_index + 1)};
+    }
+
+    const std::vector<size_t>& GetOffsets() const
+    {
+        return offsets_;
+    }
+
+    size_t size() const
+    {
+        return documents_.size();
+    }
+
+    bool empty() const
+    {
+        return documents_.empty();
+    }
+
+    auto begin() const
+    {
+        return documents_.begin();
+    }
+
+    auto end() const
+    {
+        return documents_.end();
+    }
+
+private:
+    friend class QueryExecutor;
+
+    std::vector<Document> documents_;
+    std::vector<size_t> offsets_ = {0};
+};
@@ -1,7 +1,15 @@
 #pragma once
+#include <algorithm>
+#include <cstddef>
+#include <limits>
 #include <ostream>
 #include <vector>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <execution>
+#include "document.h"
+#include "search_server.h"
 
 using namespace std::string_literals;
 
@@ -95,3 +103,156 @@ auto Paginate(const Container& cont, int page_size)
 }
 
 
+// Постраничная выдача результатов поиска. Страница запрашивается у сервера только
+// при обращении к ней. Отобранные сервером лучшие документы запоминаются, и окно выдачи
+// при выходе страницы за его границу увеличивается вдвое, поэтому обход всех страниц
+// стоит логарифмического от числа страниц количества поисков, а не поиска на каждую страницу.
+// Запомненная выдача не обновляется при изменении сервера; пагинатор не потокобезопасен
+template <typename DocumentPredicate>
+class SearchPaginator{
+public:
+    class Iterator{
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::vector<Document>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        Iterator() = default;
+
+        explicit Iterator(const SearchPaginator* paginator) : paginator_(paginator)
+        {
+            Load();
+        }
+
+        reference operator*() const
+        {
+            return page_;
+        }
+
+        pointer operator->() const
+        {
+            return &page_;
+        }
+
+        Iterator& operator++()
+        {
+            // Неполная страница — последняя, следующую запрашивать не нужно
+            if (static_cast<int>(page_.size()) < paginator_->GetPageSize())
+            {
+                paginator_ = nullptr;
+                page_.clear();
+                return *this;
+            }
+            ++page_index_;
+            Load();
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return paginator_ == other.paginator_ && (paginator_ == nullptr || page_index_ == other.page_index_);
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        const SearchPaginator* paginator_ = nullptr;
+        int page_index_ = 0;
+        std::vector<Document> page_;
+
+        void Load()
+        {
+            page_ = paginator_->GetPage(page_index_);
+            if (page_.empty())
+            {
+                paginator_ = nullptr;
+            }
+        }
+    };
+
+    SearchPaginator(const SearchServer& search_server, 
+                    std::string_view raw_query, 
+                    DocumentPredicate document_predicate, 
+                    int page_size)
+        : search_server_(&search_server), 
+        raw_query_(raw_query), 
+        document_predicate_(document_predicate), 
+        page_size_(page_size)
+    {
+        if (page_size <= 0)
+        {
+            throw std::invalid_argument("Размер страницы должен быть положительным"s);
+        }
+    }
+
+    std::vector<Document> GetPage(int page_index) const
+    {
+        if (page_index < 0)
+        {
+            throw std::out_of_range("Номер страницы не может быть отрицательным"s);
+        }
+        const size_t page_begin = static_cast<size_t>(page_index) * static_cast<size_t>(page_size_);
+        const size_t page_end = page_begin + static_cast<size_t>(page_size_);
+        if (page_end > ranked_documents_.size() && !is_ranking_complete_)
+        {
+            // Окно ограничено наибольшим числом документов, которое принимает FindTopDocuments
+            const size_t window_size = std::min(std::max(page_end, 2 * ranked_documents_.size()),
+                                                static_cast<size_t>(std::numeric_limits<int>::max()));
+            ranked_documents_ = search_server_->FindTopDocuments(std::execution::seq, raw_query_, document_predicate_,
+                                                                 0, static_cast<int>(window_size));
+            is_ranking_complete_ = ranked_documents_.size() < window_size
+                || window_size == static_cast<size_t>(std::numeric_limits<int>::max());
+        }
+        if (page_begin >= ranked_documents_.size())
+        {
+            return {};
+        }
+        return std::vector<Document>(ranked_documents_.begin() + page_begin,
+                                     ranked_documents_.begin() + std::min(page_end, ranked_documents_.size()));
+    }
+
+    int GetPageSize() const
+    {
+        return page_size_;
+    }
+
+    Iterator begin() const
+    {
+        return Iterator(this);
+    }
+
+    Iterator end() const
+    {
+        return Iterator();
+    }
+
+private:
+    const SearchServer* search_server_;
+    std::string raw_query_;
+    DocumentPredicate document_predicate_;
+    int page_size_;
+
+    // Начало выдачи, уже отобранное сервером; is_ranking_complete_ — в нём все найденные документы
+    mutable std::vector<Document> ranked_documents_;
+    mutable bool is_ranking_complete_ = false;
+};
+
+template <typename DocumentPredicate>
+auto Paginate(const SearchServer& search_server, std::string_view raw_query, DocumentPredicate document_predicate, int page_size)
+{
+    return SearchPaginator(search_server, raw_query, document_predicate, page_size);
+}
+
+inline auto Paginate(const SearchServer& search_server, std::string_view raw_query, int page_size)
+{
+    return Paginate(search_server, raw_query, 
+                    [](int, DocumentStatus document_status, int) {
+                        return document_status == DocumentStatus::ACTUAL;
+                    }, 
+                    page_size);
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "snapshot_io.h"
+
+// Список вхождений слова (posting list): отсортированные по возрастанию id документов
+// хранятся в виде разностей соседних id, упакованных в varint (по 7 бит на байт),
+// а частоты слова лежат в параллельном непрерывном массиве.
+// Для быстрого перехода к заданному id каждые SKIP_INTERVAL записей запоминается точка входа
+class PostingList {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<int, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = value_type;
+
+        Iterator() = default;
+
+        Iterator(const uint8_t* delta_pos, const uint8_t* delta_end, const double* freq_pos, 
+                 int prev_document_id = 0);
+
+        value_type operator*() const
+        {
+            return {document_id_, *freq_pos_};
+        }
+
+        int GetDocumentId() const
+        {
+            return document_id_;
+        }
+
+        double GetTermFreq() const
+        {
+            return *freq_pos_;
+        }
+
+        Iterator& operator++();
+
+        Iterator operator++(int)
+        {
+            Iterator prev = *this;
+            ++*this;
+            return prev;
+        }
+
+        bool operator==(const Iterator& other) const
+        {
+            return freq_pos_ == other.freq_pos_;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        friend class PostingList;
+
+        const uint8_t* next_delta_pos_ = nullptr;
+        const uint8_t* delta_end_ = nullptr;
+        const double* freq_pos_ = nullptr;
+        int document_id_ = 0;
+
+        void Decode();
+    };
+
+    // Дописывает частоту слова в документе в конец списка. Списки строятся только дописыванием,
+    // поэтому id документа должен быть больше всех id списка
+    void Add(int document_id, double term_freq);
+
+    size_t size() const
+    {
+        return freqs_.size();
+    }
+
+    bool empty() const
+    {
+        return freqs_.empty();
+    }
+
+    Iterator begin() const;
+
+    Iterator end() const;
+
+    // Возвращает первую запись с id не меньше document_id, начиная с позиции from
+    Iterator Seek(Iterator from, int document_id) const;
+
+    // Верхняя оценка частоты слова в документах списка. После удалений может быть завышена
+    double GetMaxTermFreq() const
+    {
+        return max_term_freq_;
+    }
+
+    // Наибольший id документа в непустом списке
+    int GetLastDocumentId() const
+    {
+        return last_document_id_;
+    }
+
+    // Сохраняет упакованные массивы списка в снимок и загружает их обратно без перекодирования.
+    // При загрузке список один раз разбирается целиком: некорректные varint, неубывающие id,
+    // расхождение точек входа, последнего id или максимальной частоты с данными приводят к исключению
+    void Save(SnapshotWriter& writer) const;
+    void Load(SnapshotReader& reader);
+
+private:
+    // Точка входа в блок из SKIP_INTERVAL записей
+    struct SkipEntry {
+        int first_document_id;
+        int prev_document_id;
+        uint32_t byte_offset;
+    };
+
+    static constexpr size_t SKIP_INTERVAL = 64;
+
+    std::vector<uint8_t> deltas_;
+    std::vector<double> freqs_;
+    std::vector<SkipEntry> skips_;
+    int last_document_id_ = 0;
+    double max_term_freq_ = 0.0;
+
+    static void AppendVarint(std::vector<uint8_t>& out, uint32_t value);
+
+    static uint32_t ReadVarint(const uint8_t*& pos);
+
+    // Читает varint, не выходя за end. Возвращает false для обрезанного или слишком длинного значения
+    static bool TryReadVarint(const uint8_t*& pos, const uint8_t* end, uint32_t& value);
+};
@@ -1,15 +1,20 @@
 #pragma once
 #include <vector>
 #include <string>
-#include <list>
 #include "search_server.h"
+#include "query_executor.h"
+#include "joined_query_results.h"
 #include "document.h"
 
+// Общий исполнитель запросов с пулом по числу аппаратных потоков
+QueryExecutor& GetDefaultQueryExecutor();
+
 std::vector<std::vector<Document>> ProcessQueries(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
 
 
-std::list<Document> ProcessQueriesJoined(
+// Результаты всех запросов подряд в порядке запросов
+JoinedQueryResults ProcessQueriesJoined(
     const SearchServer& search_server,
     const std::vector<std::string>& queries);
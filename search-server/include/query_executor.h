@@ -0,0 +1,203 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "document.h"
+#include "joined_query_results.h"
+#include "search_server.h"
+#include "search_context.h"
+#include "thread_pool.h"
+
+// Запрос из стольких слов и длиннее считается тяжёлым и делится между потоками пула
+const size_t DEFAULT_HEAVY_QUERY_WORD_COUNT = 32;
+
+// Исполнитель пакетов запросов на собственном пуле потоков с перехватом задач.
+// Пакет режется на порции запросов, которые потоки разбирают и перехватывают друг у друга;
+// лёгкие запросы выполняются целиком в одном потоке с SearchContext из пула сервера,
+// а тяжёлые дополнительно делятся по плюс-словам между свободными потоками пула
+class QueryExecutor {
+public:
+    explicit QueryExecutor(size_t thread_count = std::thread::hardware_concurrency(),
+                           size_t heavy_query_word_count = DEFAULT_HEAVY_QUERY_WORD_COUNT);
+
+    size_t GetThreadCount() const
+    {
+        return pool_.GetThreadCount();
+    }
+
+    size_t GetHeavyQueryWordCount() const
+    {
+        return heavy_query_word_count_;
+    }
+
+    ThreadPool& GetPool()
+    {
+        return pool_;
+    }
+
+    // Результаты возвращаются в порядке запросов
+    std::vector<std::vector<Document>> ProcessQueries(const SearchServer& search_server,
+                                                      const std::vector<std::string>& queries);
+
+    // Результаты всех запросов записываются потоками прямо в общий буфер без промежуточных векторов
+    JoinedQueryResults ProcessQueriesJoined(const SearchServer& search_server,
+                                            const std::vector<std::string>& queries);
+
+    // Асинхронный поиск: запрос ставится в очередь пула, а результат или исключение поиска
+    // передаётся через future. Сервер должен существовать и не изменяться до готовности результата.
+    // Незавершённые запросы выполняются при разрушении исполнителя
+    template <typename DocumentPredicate>
+    std::future<std::vector<Document>> FindTopDocumentsAsync(const SearchServer& search_server,
+                                                             std::string raw_query,
+                                                             DocumentPredicate document_predicate);
+
+    std::future<std::vector<Document>> FindTopDocumentsAsync(const SearchServer& search_server,
+                                                             std::string raw_query,
+                                                             DocumentStatus status);
+
+    std::future<std::vector<Document>> FindTopDocumentsAsync(const SearchServer& search_server,
+                                                             std::string raw_query);
+
+private:
+    // Порций на поток: достаточно для выравнивания нагрузки перехватом при малых накладных расходах
+    static constexpr size_t TASKS_PER_THREAD = 8;
+
+    // Пул объявлен последним и разрушается первым, пока остальные поля доступны его задачам
+    size_t heavy_query_word_count_;
+    ThreadPool pool_;
+
+    bool IsHeavyQuery(std::string_view query) const;
+
+    // Выполняет запросы на пуле и передаёт результат i-го запроса в consume(i, documents).
+    // Вызовы consume для разных запросов выполняются параллельно
+    void ForEachQueryResult(const SearchServer& search_server, const std::vector<std::string>& queries,
+                            const std::function<void(size_t, const std::vector<Document>&)>& consume);
+
+    // Ставит в очередь части поиска тяжёлого запроса отдельными задачами пула.
+    // Выдачу собирает часть, завершившаяся последней, поэтому задачи не ждут друг друга
+    template <typename DocumentPredicate>
+    std::future<std::vector<Document>> FindTopDocumentsByParts(const SearchServer& search_server,
+                                                               std::string raw_query,
+                                                               DocumentPredicate document_predicate);
+};
+
+template <typename DocumentPredicate>
+std::future<std::vector<Document>> QueryExecutor::FindTopDocumentsAsync(const SearchServer& search_server,
+                                                                        std::string raw_query,
+                                                                        DocumentPredicate document_predicate)
+{
+    if (IsHeavyQuery(raw_query))
+    {
+        return FindTopDocumentsByParts(search_server, std::move(raw_query), document_predicate);
+    }
+
+    // std::function требует копируемой задачи, поэтому обещание разделяется через shared_ptr
+    auto promise = std::make_shared<std::promise<std::vector<Document>>>();
+    std::future<std::vector<Document>> result = promise->get_future();
+
+    // Контекст возвращается в пул сервера до готовности результата: после неё сервер может быть разрушен
+    pool_.Submit([&search_server, raw_query = std::move(raw_query), document_predicate, promise] {
+        SearchContextPool::Handle context;
+        try
+        {
+            context = search_server.AcquireSearchContext();
+            std::vector<Document> documents = search_server.FindTopDocuments(*context, std::execution::seq,
+                                                                             raw_query, document_predicate,
+                                                                             0, MAX_RESULT_DOCUMENT_COUNT);
+            context.reset();
+            promise->set_value(std::move(documents));
+        }
+        catch (...)
+        {
+            context.reset();
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return result;
+}
+
+template <typename DocumentPredicate>
+std::future<std::vector<Document>> QueryExecutor::FindTopDocumentsByParts(const SearchServer& search_server,
+                                                                          std::string raw_query,
+                                                                          DocumentPredicate document_predicate)
+{
+    // Общее состояние частей; контекст хранит разобранный запрос со ссылками на raw_query
+    struct PartitionedQuery {
+        std::string raw_query;
+        SearchContextPool::Handle context;
+        std::promise<std::vector<Document>> promise;
+        std::atomic<size_t> remaining_part_count{0};
+        std::mutex error_mutex;
+        std::exception_ptr error;
+    };
+    const auto query = std::make_shared<PartitionedQuery>();
+    query->raw_query = std::move(raw_query);
+    std::future<std::vector<Document>> result = query->promise.get_future();
+
+    size_t part_count = 0;
+    try
+    {
+        query->context = search_server.AcquireSearchContext();
+        part_count = search_server.StartPartitionedSearch(*query->context, query->raw_query, pool_.GetThreadCount());
+    }
+    catch (...)
+    {
+        query->context.reset();
+        query->promise.set_exception(std::current_exception());
+        return result;
+    }
+
+    query->remaining_part_count.store(part_count, std::memory_order_relaxed);
+    for (size_t part = 0; part < part_count; ++part)
+    {
+        pool_.Submit([&search_server, document_predicate, query, part] {
+            try
+            {
+                search_server.SearchPart(*query->context, part, document_predicate);
+            }
+            catch (...)
+            {
+                std::lock_guard guard(query->error_mutex);
+                if (!query->error)
+                {
+                    query->error = std::current_exception();
+                }
+            }
+            // Уменьшение счётчика упорядочивает результаты и ошибки всех частей перед сборкой выдачи
+            if (query->remaining_part_count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            {
+                return;
+            }
+            // Контекст возвращается в пул до готовности результата, а не при разрушении общего состояния:
+            // последняя ссылка на него может освободиться уже после разрушения сервера
+            if (query->error)
+            {
+                query->context.reset();
+                query->promise.set_exception(query->error);
+                return;
+            }
+            try
+            {
+                std::vector<Document> documents = search_server.FinishPartitionedSearch(*query->context,
+                                                                                        0, MAX_RESULT_DOCUMENT_COUNT);
+                query->context.reset();
+                query->promise.set_value(std::move(documents));
+            }
+            catch (...)
+            {
+                query->context.reset();
+                query->promise.set_exception(std::current_exception());
+            }
+        });
+    }
+    return result;
+}
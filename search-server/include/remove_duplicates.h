@@ -1,5 +1,23 @@
 #pragma once
+#include <vector>
 #include "search_server.h"
 
+// Доля общих слов (коэффициент Жаккара), начиная с которой документы считаются почти дубликатами
+const double DEFAULT_MIN_SIMILARITY = 0.8;
+
+// Дубликат — документ, множество слов которого без стоп-слов совпадает с множеством слов документа
+// с меньшим id. Множество номеров слов сводится к 128-битному отпечатку, отпечатки считаются параллельно
+// по документам и сравниваются через хеш-таблицу. Возвращает id дубликатов по возрастанию
+std::vector<int> FindDuplicates(const SearchServer& search_server);
+
+// Почти дубликат — документ, у которого коэффициент Жаккара множеств слов с одним из оставленных
+// документов меньшего id не меньше min_similarity. Кандидаты отбираются по MinHash-подписям,
+// посчитанным параллельно по документам и разбитым на полосы (LSH), а сходство кандидатов
+// проверяется точно и параллельно по блокам документов. Корзина LSH хранит ограниченное число
+// оставленных документов, поэтому копии одного документа не делают проверку квадратичной.
+// Возвращает id почти дубликатов по возрастанию
+std::vector<int> FindNearDuplicates(const SearchServer& search_server, double min_similarity = DEFAULT_MIN_SIMILARITY);
+
 void RemoveDuplicates(SearchServer& search_server);
 
+void RemoveNearDuplicates(SearchServer& search_server, double min_similarity = DEFAULT_MIN_SIMILARITY);
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Накопитель релевантности документов, индексируемый плотными номерами (слотами) документов.
+// Очки хранятся в непрерывном массиве, а список затронутых слотов позволяет обходить
+// и очищать только реально найденные документы. Для параллельного подсчёта каждый поток
+// заполняет собственный накопитель без блокировок, после чего накопители сливаются через Merge
+class ScoreAccumulator {
+public:
+    explicit ScoreAccumulator(size_t slot_count = 0);
+
+    // Очищает затронутые слоты и при необходимости увеличивает размер до slot_count
+    void Reset(size_t slot_count);
+
+    void Add(int slot, double score)
+    {
+        if (states_[slot] == SlotState::EMPTY)
+        {
+            states_[slot] = SlotState::SCORED;
+            touched_slots_.push_back(slot);
+        }
+        scores_[slot] += score;
+    }
+
+    // Исключает документ из результата (например, из-за минус-слова).
+    // Вызывается после всех Add: незатронутые слоты не отмечаются
+    void Exclude(int slot)
+    {
+        if (states_[slot] == SlotState::SCORED)
+        {
+            states_[slot] = SlotState::EXCLUDED;
+        }
+    }
+
+    // Прибавляет очки другого накопителя, сброшенного на то же количество слотов
+    void Merge(const ScoreAccumulator& other);
+
+    // Вызывает func(slot, score) для каждого набравшего очки и не исключённого слота
+    template <typename Func>
+    void ForEach(Func func) const
+    {
+        for (int slot : touched_slots_)
+        {
+            if (states_[slot] == SlotState::SCORED)
+            {
+                func(slot, scores_[slot]);
+            }
+        }
+    }
+
+    // Количество затронутых слотов, включая исключённые
+    size_t GetTouchedCount() const
+    {
+        return touched_slots_.size();
+    }
+
+private:
+    enum class SlotState : uint8_t {
+        EMPTY,
+        SCORED,
+        EXCLUDED,
+    };
+
+    std::vector<double> scores_;
+    std::vector<SlotState> states_;
+    std::vector<int> touched_slots_;
+};
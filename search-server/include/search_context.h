@@ -0,0 +1,89 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "document.h"
+#include "posting_list.h"
+#include "score_accumulator.h"
+
+// Буферы поиска, переиспользуемые между запросами к SearchServer: накопители релевантности,
+// куча лучших документов с результатом и рабочие массивы отсечения MaxScore.
+// Буферы только растут, поэтому после первых запросов поиск с контекстом не выделяет память.
+// Контекст не потокобезопасен: каждый поток использует собственный
+class SearchContext {
+public:
+    SearchContext() = default;
+
+private:
+    friend class SearchServer;
+
+    // Позиция в списке вхождений плюс- или минус-слова для отсечения MaxScore
+    struct TermCursor {
+        const PostingList* postings;
+        PostingList::Iterator it;
+        PostingList::Iterator end;
+        double inverse_document_freq;
+        double max_score;
+    };
+
+    ScoreAccumulator accumulator_;
+    std::vector<ScoreAccumulator> partial_accumulators_;
+    std::vector<Document> top_documents_;
+
+    // Разобранный запрос поиска по частям и число его частей
+    std::vector<std::string_view> plus_words_;
+    std::vector<std::string_view> minus_words_;
+    size_t part_count_ = 0;
+
+    std::vector<TermCursor> cursors_;
+    std::vector<TermCursor> minus_cursors_;
+    std::vector<double> prefix_max_scores_;
+    std::vector<double> window_scores_;
+    std::vector<uint8_t> window_hits_;
+};
+
+// Пул контекстов поиска. Контекст выдаётся во временное владение и возвращается в пул при разрушении
+// дескриптора, поэтому поиск без явного контекста переиспользует уже выделенные буферы.
+// Свободных контекстов хранится не больше, чем потоков процессора: память буферов ограничена числом
+// одновременных запросов, а не числом потоков, когда-либо искавших в сервере.
+// Копия пула пуста, так как буферы не относятся к содержимому сервера
+class SearchContextPool {
+public:
+    class Releaser {
+    public:
+        explicit Releaser(SearchContextPool* pool = nullptr)
+            : pool_(pool)
+        {
+        }
+
+        void operator()(SearchContext* context) const;
+
+    private:
+        SearchContextPool* pool_;
+    };
+
+    // Дескриптор не должен пережить пул
+    using Handle = std::unique_ptr<SearchContext, Releaser>;
+
+    SearchContextPool() = default;
+
+    SearchContextPool(const SearchContextPool&)
+    {
+    }
+
+    SearchContextPool& operator=(const SearchContextPool&)
+    {
+        return *this;
+    }
+
+    Handle Acquire();
+
+private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<SearchContext>> idle_contexts_;
+
+    void Release(SearchContext* context);
+};
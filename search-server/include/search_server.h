@@ -5,20 +5,58 @@
 #include <map>
 #include <set>
 #include <unordered_set>
+#include <unordered_map>
 #include <tuple>
 #include <stdexcept>
 #include <cmath>
+#include <limits>
 #include <algorithm>
+#include <numeric>
 #include <execution>
+#include <thread>
+#include <memory>
+#include <functional>
 #include "document.h"
 #include "string_processing.h"
-#include "concurrent_map.h"
+#include "posting_list.h"
+#include "string_arena.h"
+#include "term_dictionary.h"
+#include "score_accumulator.h"
+#include "snapshot_io.h"
+#include "small_vector.h"
+#include "stop_word_filter.h"
+#include "search_context.h"
+#include "thread_pool.h"
 
 using namespace std::string_literals;
 
 constexpr double RELEVANCE_ERROR = 1e-6;
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 
+namespace search_policy {
+
+// Политика FindTopDocuments с динамическим отсечением MaxScore: документы обходятся
+// окнами по возрастанию слота, и списки вхождений, которые сами по себе не могут
+// поднять документ в топ, не перебираются, а только проверяются для кандидатов
+// из остальных списков. Результат совпадает с полным подсчётом
+struct MaxScorePolicy {};
+
+inline constexpr MaxScorePolicy max_score{};
+
+// Политика выполнения на пуле потоков: плюс-слова запроса делятся на группы по числу
+// потоков пула. Поток, запустивший поиск, участвует в работе, поэтому политику можно
+// использовать и внутри задач того же пула
+struct ThreadPoolPolicy {
+    ThreadPool* pool;
+};
+
+inline ThreadPoolPolicy on(ThreadPool& pool)
+{
+    return {&pool};
+}
+
+}
+
 class SearchServer {
 public:
     template <typename StringContainer>
@@ -31,6 +69,13 @@ public:
                     DocumentStatus status, 
                     const std::vector<int>& ratings);
 
+    // Пакетное добавление документов: разбор текстов и поиск слов в словаре выполняются
+    // параллельно для parallel_policy, а каждый список вхождений пополняется за один проход.
+    // Если хотя бы один документ некорректен, сервер не изменяется
+    void AddDocuments(const std::vector<DocumentToAdd>& documents);
+    void AddDocuments(std::execution::sequenced_policy, const std::vector<DocumentToAdd>& documents);
+    void AddDocuments(std::execution::parallel_policy, const std::vector<DocumentToAdd>& documents);
+
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const ;
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
@@ -40,6 +85,20 @@ public:
     std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, 
                                            std::string_view raw_query, 
                                            DocumentPredicate document_predicate) const;
+    // Возвращает не более max_result_count самых релевантных документов
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, 
+                                           std::string_view raw_query, 
+                                           DocumentPredicate document_predicate,
+                                           int max_result_count) const;
+    // Возвращает окно выдачи: не более max_result_count документов, начиная с позиции offset.
+    // Отбираются только offset + max_result_count лучших документов
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, 
+                                           std::string_view raw_query, 
+                                           DocumentPredicate document_predicate,
+                                           int offset,
+                                           int max_result_count) const;
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, 
                                            std::string_view raw_query, 
@@ -48,8 +107,51 @@ public:
     std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, 
                                            std::string_view raw_query) const;
 
+    // Поиск с буферами контекста: после первых запросов не выделяет память в куче.
+    // Результат хранится в контексте и действителен до следующего поиска с этим контекстом
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    const std::vector<Document>& FindTopDocuments(SearchContext& context,
+                                                  const ExecutionPolicy& policy, 
+                                                  std::string_view raw_query, 
+                                                  DocumentPredicate document_predicate,
+                                                  int offset,
+                                                  int max_result_count) const;
+    template <typename DocumentPredicate>
+    const std::vector<Document>& FindTopDocuments(SearchContext& context,
+                                                  std::string_view raw_query, 
+                                                  DocumentPredicate document_predicate) const;
+    const std::vector<Document>& FindTopDocuments(SearchContext& context,
+                                                  std::string_view raw_query, 
+                                                  DocumentStatus status) const;
+    const std::vector<Document>& FindTopDocuments(SearchContext& context, std::string_view raw_query) const;
+
+    // Контекст из пула сервера; поиск без явного контекста берёт контексты отсюда же.
+    // Дескриптор не должен пережить сервер
+    SearchContextPool::Handle AcquireSearchContext() const
+    {
+        return context_pool_.Acquire();
+    }
+
+    // Поиск по частям для задач пула, которые не должны блокироваться в ожидании друг друга.
+    // StartPartitionedSearch разбирает запрос, делит плюс-слова не более чем на max_part_count частей
+    // (и не более чем на MAX_QUERY_GROUP_COUNT)
+    // и возвращает их число. Части SearchPart независимы и могут выполняться параллельно, а после
+    // всех частей FinishPartitionedSearch исключает документы минус-слов и отбирает выдачу.
+    // Текст запроса должен существовать до завершения поиска
+    size_t StartPartitionedSearch(SearchContext& context, std::string_view raw_query, size_t max_part_count) const;
+    template <typename DocumentPredicate>
+    void SearchPart(SearchContext& context, size_t part, DocumentPredicate document_predicate) const;
+    const std::vector<Document>& FinishPartitionedSearch(SearchContext& context,
+                                                         int offset,
+                                                         int max_result_count) const;
+
     int GetDocumentCount() const;
 
+    // Порядок выдачи: по убыванию релевантности, при равной (с точностью RELEVANCE_ERROR)
+    // релевантности — по убыванию рейтинга, затем по возрастанию id. Порядок строгий, поэтому выдача
+    // с offset и limit совпадает с соответствующим отрезком полной выдачи при любом способе поиска
+    static bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, 
                                                                         int document_id) const;
     template<typename ExecutionPolicy>
@@ -59,12 +161,85 @@ public:
     
     int GetDocumentId(int index) const;
 
-    const std::map<std::string, double, std::less<>>& GetWordFrequencies(int document_id) const;
+    // Частоты слов документа. Представления слов валидны, пока жив сервер или его копии
+    // и пока сервер не очищен от удалённых документов: очистка переносит словарь в новое хранилище
+    std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
+
+    // Номера слов документа по возрастанию; для отсутствующего документа вектор пуст.
+    // Номера совпадают у сервера и всех его копий, поэтому по ним можно сравнивать документы.
+    // Очистка от удалённых документов перенумеровывает слова
+    void GetDocumentTermIds(int document_id, std::vector<TermId>& term_ids) const;
     
+    // Удаление логическое: слот документа помечается надгробием, а документные частоты его слов
+    // уменьшаются, поэтому выдача сразу совпадает с выдачей без документа. Списки вхождений
+    // не переписываются; список, в котором не осталось живых документов, освобождается сразу
     void RemoveDocument(int document_id); 
     void RemoveDocument(std::execution::sequenced_policy, int document_id);
     void RemoveDocument(std::execution::parallel_policy, int document_id);
 
+    // Пакетное удаление: вхождения всех удаляемых документов группируются по словам, и документная
+    // частота каждого затронутого слова обновляется один раз, для parallel_policy — параллельно по словам.
+    // Отсутствующие и повторяющиеся id пропускаются. Если после пакета удалённых слотов не меньше
+    // живых, списки вхождений переписываются одной очисткой
+    void RemoveDocuments(const std::vector<int>& document_ids);
+    void RemoveDocuments(std::execution::sequenced_policy, const std::vector<int>& document_ids);
+    void RemoveDocuments(std::execution::parallel_policy, const std::vector<int>& document_ids);
+
+    // Физически удаляет помеченные документы: списки вхождений перестраиваются параллельно
+    // по словам, а слоты уплотняются. Слова, не оставшиеся ни в одном документе, выбрасываются
+    // из словаря, остальные нумеруются заново подряд. Вызывается автоматически, когда удалённых
+    // слотов накопилось не меньше, чем живых
+    void PurgeRemovedDocuments();
+
+    // Сохраняет полное состояние сервера (стоп-слова, словарь, списки вхождений, данные документов)
+    // в двоичный снимок с номером версии формата
+    void SaveSnapshot(const std::string& path) const;
+
+    // Загружает сервер из снимка с проверкой целостности: без повторного разбора документов,
+    // но индекс строится в куче, а не обслуживается со страниц файла. Файл отображается в память
+    // только на время загрузки, чтобы копировать массивы без промежуточного буфера чтения;
+    // каждый список вхождений при этом разбирается целиком, поэтому время загрузки и память
+    // пропорциональны размеру снимка. После загрузки сервер не зависит от файла
+    static SearchServer LoadSnapshot(const std::string& path);
+
+    bool HasDocument(int document_id) const;
+
+    // Операции для индекса из нескольких серверов-сегментов с общими стоп-словами (SegmentedSearchServer)
+
+    // Переносит документы сервера source без повторного разбора текста: частоты слов, статус
+    // и рейтинг копируются из прямого индекса. Документы, для которых is_removed(id) истинно, пропускаются
+    void AppendDocuments(const SearchServer& source, const std::function<bool(int)>& is_removed);
+
+    // Слова запроса без стоп-слов, отсортированные и без повторов.
+    // Типичный запрос помещается во встроенные буферы и не выделяет память в куче
+    static constexpr size_t QUERY_INLINE_WORD_COUNT = 16;
+    using QueryWords = SmallVector<std::string_view, QUERY_INLINE_WORD_COUNT>;
+
+    // Слова ссылаются на текст запроса, который должен существовать, пока используется разбор
+    struct Query {
+        QueryWords plus_words;
+        QueryWords minus_words;
+    };
+
+    // Разбирает запрос за один проход по тексту: разбиение на слова совмещено с проверкой
+    // на спецсимволы, после чего каждое слово один раз классифицируется как плюс-, минус- или стоп-слово.
+    // Разбор зависит только от стоп-слов и подходит всем серверам с теми же стоп-словами
+    Query ParseQuery(std::string_view text) const;
+
+    // Количество документов с каждым плюс-словом запроса в порядке разбора запроса
+    void GetQueryDocumentFreqs(const Query& query, std::vector<int>& document_freqs) const;
+
+    // Поиск со статистикой всего индекса: IDF i-го плюс-слова задан inverse_document_freqs[i]
+    // в порядке GetQueryDocumentFreqs, поэтому релевантность сравнима между сегментами.
+    // Политика search_policy::max_score выполняется последовательным полным подсчётом с тем же результатом
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    const std::vector<Document>& FindTopDocumentsInSegment(SearchContext& context,
+                                                           const ExecutionPolicy& policy,
+                                                           const Query& query,
+                                                           const std::vector<double>& inverse_document_freqs,
+                                                           DocumentPredicate document_predicate,
+                                                           int max_result_count) const;
+
     auto begin() const
     {
         return doc_ids_.begin();
@@ -76,61 +251,173 @@ public:
     }
 
 private:
-    struct DocumentData {
-        int rating;
-        DocumentStatus status;
-    };
+    // Хранилище текста стоп-слов. Разделяется копиями сервера,
+    // поэтому представления слов не зависят от времени жизни переданных строк
+    std::shared_ptr<StringArena> arena_;
 
-    const std::unordered_set<std::string_view, std::hash<std::string_view>, std::equal_to<std::string_view>> stop_words_;
+    const StopWordFilter stop_words_;
     
     std::set<int> doc_ids_;
-    
-    std::map<int, std::map<std::string, double, std::less<>>> doc_to_words_freeqs_;
 
-    std::map<std::string, std::map<int, double>, std::less<>> word_to_document_freqs_;
+    // Буферы поиска без явного контекста: накопители размером в число слотов не выделяются
+    // и не обнуляются заново для каждого запроса
+    mutable SearchContextPool context_pool_;
+
+    // Слова документов и запросов переводятся в номера словаря, индексы хранят только номера.
+    // У словаря своё хранилище строк, которое очистка заменяет, выбрасывая слова без живых документов
+    TermDictionary dictionary_;
+
+    // Список вхождений слова вместе с логарифмом его документной частоты.
+    // IDF = log(N) - log(df): log(df) обновляется вместе со списком, а log(N) хранится один на индекс
+    struct WordPostings {
+        PostingList postings;
+        // Число живых документов со словом: удалённые документы остаются в postings до очистки
+        int document_freq = 0;
+        double log_document_freq = 0.0;
+
+        void UpdateDocumentFreq()
+        {
+            log_document_freq = std::log(static_cast<double>(document_freq));
+        }
+    };
+
+    // Обратный индекс по номеру слова. Списки вхождений хранят не id документов,
+    // а их внутренние плотные номера (слоты)
+    std::vector<WordPostings> term_postings_;
+
+    double log_document_count_ = 0.0;
     
-    std::map<int, DocumentData> documents_;
+    // Слоты выдаются по возрастанию и не переиспользуются, поэтому списки вхождений
+    // пополняются только добавлением в конец
+    std::unordered_map<int, int> document_to_slot_;
+
+    // Данные документов в виде параллельных массивов, индексируемых слотом
+    std::vector<int> slot_document_ids_;
+    std::vector<int> slot_ratings_;
+    std::vector<DocumentStatus> slot_statuses_;
+
+    // Прямой индекс: частоты слов документа, упорядоченные по номеру слова
+    using TermFreqs = std::vector<std::pair<TermId, double>>;
+    std::vector<TermFreqs> slot_term_freqs_;
+
+    // Надгробия: слоты удалённых документов, которые ещё присутствуют в списках вхождений.
+    // Поиск пропускает такие слоты, а PurgeRemovedDocuments удаляет их физически
+    std::vector<bool> removed_slots_;
+    size_t removed_slot_count_ = 0;
+
+    // Очистка запускается, когда удалённых слотов не меньше живых и не меньше этого числа,
+    // поэтому каждый слот переписывается ею амортизированно O(1) раз
+    static constexpr size_t MIN_PURGE_SLOT_COUNT = 1024;
 
     bool IsStopWord(std::string_view word) const;
 
     static bool IsValidWord(std::string_view word);
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+    template <typename StringContainer>
+    static StopWordFilter StoreStopWords(const StringContainer& stop_words, StringArena& arena);
+
+    // Разбивает текст на слова без стоп-слов, дописывая их в words
+    void SplitIntoWordsNoStop(std::string_view text, std::vector<std::string_view>& words) const;
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
-    struct QueryWord {
-        std::string_view data;
-        bool is_minus;
-        bool is_stop;
-    };
+    // Проверяет, что id документа корректен и ещё не занят
+    void CheckNewDocumentId(int document_id) const;
 
-    QueryWord ParseQueryWord(std::string_view text) const;
-    
-    struct Query {
-        std::unordered_set<std::string_view, std::hash<std::string_view>, std::equal_to<std::string_view>> plus_words;
-        std::unordered_set<std::string_view, std::hash<std::string_view>, std::equal_to<std::string_view>> minus_words;
-    };
+    // Выделяет документу следующий слот и сохраняет его данные. Списки вхождений не изменяются
+    void AppendSlot(int document_id, DocumentStatus status, int rating, TermFreqs term_freqs);
 
-    Query ParseQuery(std::string_view text) const;
-    
-    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+    template <typename ExecutionPolicy>
+    void AddDocumentsImpl(const ExecutionPolicy& policy, const std::vector<DocumentToAdd>& documents);
+
+    template <typename ExecutionPolicy>
+    void RemoveDocumentsImpl(const ExecutionPolicy& policy, const std::vector<int>& document_ids);
+
+    // Очищает слоты, если удалённых накопилось не меньше живых
+    void PurgeRemovedDocumentsIfNeeded();
+
+    // Выбрасывает из словаря слова без живых документов и перенумеровывает остальные
+    // в списках вхождений и прямом индексе
+    void CompactTerms();
+
+    double ComputeWordInverseDocumentFreq(const WordPostings& word_postings) const
+    {
+        return log_document_count_ - word_postings.log_document_freq;
+    }
+
+    void UpdateDocumentCount();
+
+    // Список вхождений слова либо nullptr, если документов с этим словом нет
+    const WordPostings* FindWordPostings(std::string_view word) const;
+
+    bool DocumentContainsWord(int slot, std::string_view word) const;
 
+
+    // Добавляет в accumulator документы с плюс-словом. IDF берётся из inverse_document_freq,
+    // если он задан, иначе вычисляется по этому серверу
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, 
-                                           DocumentPredicate document_predicate) const;
+    void AddPlusWordDocuments(std::string_view word,
+                              DocumentPredicate& document_predicate,
+                              const double* inverse_document_freq,
+                              ScoreAccumulator& accumulator) const;
+
+    template <typename Words>
+    void ExcludeMinusWordDocuments(const Words& minus_words, ScoreAccumulator& accumulator) const;
+
+    // Обнуляет накопители part_count частей поиска в контексте
+    void ResetPartialAccumulators(SearchContext& context, size_t part_count) const;
+
+    // Собирает накопители частей в context.accumulator_, буферы всех накопителей остаются в контексте
+    static void MergePartialAccumulators(SearchContext& context, size_t part_count);
+
+    // Наибольшее число групп плюс-слов параллельного поиска. Каждая группа держит в контексте
+    // плотный накопитель на все слоты, а пул хранит до числа потоков контекстов, поэтому без
+    // ограничения память накопителей росла бы квадратично по числу потоков
+    static constexpr size_t MAX_QUERY_GROUP_COUNT = 8;
+
+    // Подсчитывает релевантность найденных документов в context.accumulator_
+    template <typename DocumentPredicate>
+    void FindAllDocuments(const Query& query, 
+                          DocumentPredicate document_predicate,
+                          SearchContext& context) const;
     
+    // Если inverse_document_freqs задан, IDF плюс-слов берётся из него, а не из этого сервера
     template <typename DocumentPredicate, typename ExecutionPolicy>
-    std::vector<Document> FindAllDocuments(const ExecutionPolicy& policy, 
-                                           const Query& query, 
-                                           DocumentPredicate document_predicate) const;
+    void FindAllDocuments(const ExecutionPolicy& policy, 
+                          const Query& query, 
+                          DocumentPredicate document_predicate,
+                          SearchContext& context,
+                          const double* inverse_document_freqs = nullptr) const;
+
+    // Отбирает в top_documents документы с позиций [offset, offset + max_result_count) выдачи
+    // ограниченной кучей, не сортируя все найденные
+    void SelectTopDocuments(const ScoreAccumulator& accumulator, 
+                            int offset,
+                            int max_result_count,
+                            std::vector<Document>& top_documents) const;
+
+    // Добавляет документ в кучу лучших размером не более heap_size. В вершине кучи
+    // находится наименее релевантный из отобранных документов
+    static void PushTopDocument(std::vector<Document>& heap, size_t heap_size, const Document& document);
+
+    // Сортирует кучу лучших по убыванию релевантности и отбрасывает первые offset документов
+    static void FinishTopDocuments(std::vector<Document>& heap, int offset);
+
+    // Отбирает лучшие документы с отсечением MaxScore в context.top_documents_
+    template <typename DocumentPredicate>
+    void FindTopDocumentsMaxScore(const Query& query, 
+                                  DocumentPredicate document_predicate,
+                                  int offset,
+                                  int max_result_count,
+                                  SearchContext& context) const;
     
 
 };
 
 template <typename StringContainer>
 SearchServer::SearchServer(const StringContainer& stop_words) 
-    : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+    : arena_(std::make_shared<StringArena>()),
+    stop_words_(StoreStopWords(stop_words, *arena_))
 {
     for (std::string_view word : stop_words_)
     {
@@ -141,22 +428,32 @@ SearchServer::SearchServer(const StringContainer& stop_words)
     }
 }
 
+template <typename StringContainer>
+StopWordFilter SearchServer::StoreStopWords(const StringContainer& stop_words, StringArena& arena)
+{
+    std::vector<std::string_view> stored_stop_words;
+    for (std::string_view word : MakeUniqueNonEmptyStrings(stop_words))
+    {
+        stored_stop_words.push_back(arena.Store(word));
+    }
+    return StopWordFilter(stored_stop_words);
+}
+
 template<typename ExecutionPolicy>
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const ExecutionPolicy& policy,
                                                                        std::string_view raw_query, 
                                                                        int document_id) const {   
-    if (!doc_ids_.count(document_id)) {
+    const auto slot_it = document_to_slot_.find(document_id);
+    if (slot_it == document_to_slot_.end()) {
         throw std::out_of_range("Документа с данным id не существует.");
     }
-    
-    auto words_freqs_it = doc_to_words_freeqs_.find(document_id);    
-
-    const auto& words_freeqs = words_freqs_it->second;
+    const int slot = slot_it->second;
+    const DocumentStatus status = slot_statuses_[slot];
     
     Query query = ParseQuery(raw_query);
     
-    auto find_minus_words = [&words_freeqs](std::string_view word){
-        return words_freeqs.find(word) != words_freeqs.end();
+    auto find_minus_words = [this, slot](std::string_view word){
+        return DocumentContainsWord(slot, word);
     };
 
 
@@ -168,20 +465,20 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     {
         static std::vector<std::string_view> empty_vector;
 
-        return {empty_vector, documents_.at(document_id).status};
+        return {empty_vector, status};
  
     }
     
     std::vector<std::string_view> matched_words;
     for (std::string_view word : query.plus_words) {
         
-        if (words_freeqs.find(word) != words_freeqs.end())
+        if (DocumentContainsWord(slot, word))
         {
             matched_words.push_back(word);
         }
     }
     
-    return {matched_words, documents_.at(document_id).status};
+    return {matched_words, status};
 }
 
 
@@ -198,27 +495,67 @@ std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& poli
                                                      std::string_view raw_query, 
                                                      DocumentPredicate document_predicate) const
 {
+    return FindTopDocuments(policy, raw_query, document_predicate, MAX_RESULT_DOCUMENT_COUNT);
+}
 
-    Query query = ParseQuery(raw_query);
-    auto matched_documents = FindAllDocuments(policy, query, document_predicate);
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, 
+                                                     std::string_view raw_query, 
+                                                     DocumentPredicate document_predicate,
+                                                     int max_result_count) const
+{
+    return FindTopDocuments(policy, raw_query, document_predicate, 0, max_result_count);
+}
 
-    sort(
-        policy,
-        matched_documents.begin(), matched_documents.end(),
-            [](const Document& lhs, const Document& rhs) 
-            {
-                if (std::abs(lhs.relevance - rhs.relevance) < RELEVANCE_ERROR) 
-                {
-                    return lhs.rating > rhs.rating;
-                } else {
-                     return lhs.relevance > rhs.relevance;
-                }
-             });
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& policy, 
+                                                     std::string_view raw_query, 
+                                                     DocumentPredicate document_predicate,
+                                                     int offset,
+                                                     int max_result_count) const
+{
+    // Результат копируется, чтобы буфер кучи лучших документов остался в контексте пула
+    const SearchContextPool::Handle context = context_pool_.Acquire();
+    return FindTopDocuments(*context, policy, raw_query, document_predicate, offset, max_result_count);
+}
 
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+template <typename DocumentPredicate, typename ExecutionPolicy>
+const std::vector<Document>& SearchServer::FindTopDocuments(SearchContext& context,
+                                                            const ExecutionPolicy& policy, 
+                                                            std::string_view raw_query, 
+                                                            DocumentPredicate document_predicate,
+                                                            int offset,
+                                                            int max_result_count) const
+{
+    if (max_result_count < 0)
+    {
+        throw std::invalid_argument("Количество документов в выдаче не может быть отрицательным"s);
+    }
+    if (offset < 0)
+    {
+        throw std::invalid_argument("Смещение в выдаче не может быть отрицательным"s);
+    }
+
+    const Query query = ParseQuery(raw_query);
+    if constexpr (std::is_same_v<ExecutionPolicy, search_policy::MaxScorePolicy>)
+    {
+        FindTopDocumentsMaxScore(query, document_predicate, offset, max_result_count, context);
+    }
+    else
+    {
+        FindAllDocuments(policy, query, document_predicate, context);
+        SelectTopDocuments(context.accumulator_, offset, max_result_count, context.top_documents_);
     }
-    return matched_documents;
+    return context.top_documents_;
+}
+
+template <typename DocumentPredicate>
+const std::vector<Document>& SearchServer::FindTopDocuments(SearchContext& context,
+                                                            std::string_view raw_query, 
+                                                            DocumentPredicate document_predicate) const
+{
+    return FindTopDocuments(context, std::execution::seq, raw_query, document_predicate, 
+                            0, MAX_RESULT_DOCUMENT_COUNT);
 }
 
 template <typename ExecutionPolicy>
@@ -240,92 +577,308 @@ std::vector<Document> SearchServer::FindTopDocuments(const ExecutionPolicy& poli
     return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
+template <typename DocumentPredicate, typename ExecutionPolicy>
+const std::vector<Document>& SearchServer::FindTopDocumentsInSegment(SearchContext& context,
+                                                                     const ExecutionPolicy& policy,
+                                                                     const Query& query,
+                                                                     const std::vector<double>& inverse_document_freqs,
+                                                                     DocumentPredicate document_predicate,
+                                                                     int max_result_count) const
+{
+    if (inverse_document_freqs.size() != query.plus_words.size())
+    {
+        throw std::invalid_argument("Число значений IDF не совпадает с числом плюс-слов запроса"s);
+    }
+    FindAllDocuments(policy, query, document_predicate, context, inverse_document_freqs.data());
+    SelectTopDocuments(context.accumulator_, 0, max_result_count, context.top_documents_);
+    return context.top_documents_;
+}
+
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const SearchServer::Query& query,
-                                                    DocumentPredicate document_predicate) const 
+void SearchServer::FindAllDocuments(const SearchServer::Query& query,
+                                    DocumentPredicate document_predicate,
+                                    SearchContext& context) const 
 {
-    return FindAllDocuments(std::execution::seq, query, document_predicate);
+    FindAllDocuments(std::execution::seq, query, document_predicate, context);
 }
 
 
 template <typename DocumentPredicate, typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindAllDocuments(const ExecutionPolicy& policy,
-                                                     const SearchServer::Query& query,
-                                                     DocumentPredicate document_predicate) const 
+void SearchServer::FindAllDocuments(const ExecutionPolicy& policy,
+                                    const SearchServer::Query& query,
+                                    DocumentPredicate document_predicate,
+                                    SearchContext& context,
+                                    const double* inverse_document_freqs) const 
+{
+    auto add_docs_by_plus_word = [this, &query, &document_predicate, inverse_document_freqs](size_t word_index, 
+                                                                                          ScoreAccumulator& accumulator) {
+        AddPlusWordDocuments(query.plus_words[word_index], document_predicate,
+                             inverse_document_freqs != nullptr ? inverse_document_freqs + word_index : nullptr,
+                             accumulator);
+    };
+
+    ScoreAccumulator& accumulator = context.accumulator_;
+    accumulator.Reset(slot_document_ids_.size());
+
+    constexpr bool is_pool_policy = std::is_same_v<ExecutionPolicy, search_policy::ThreadPoolPolicy>;
+    if constexpr (std::is_same_v<ExecutionPolicy, std::execution::parallel_policy> || is_pool_policy)
+    {
+        // Плюс-слова делятся на группы по числу потоков, каждая группа считается
+        // в собственный накопитель без блокировок, затем накопители суммируются
+        const QueryWords& plus_words = query.plus_words;
+        size_t concurrency = std::thread::hardware_concurrency();
+        if constexpr (is_pool_policy)
+        {
+            concurrency = policy.pool->GetThreadCount();
+        }
+        const size_t group_count = std::max<size_t>(
+            1, std::min({plus_words.size(), concurrency, MAX_QUERY_GROUP_COUNT}));
+
+        ResetPartialAccumulators(context, group_count);
+        std::vector<ScoreAccumulator>& partial_accumulators = context.partial_accumulators_;
+        auto process_group = [&](size_t group){
+            for (size_t i = group; i < plus_words.size(); i += group_count)
+            {
+                add_docs_by_plus_word(i, partial_accumulators[group]);
+            }
+        };
+
+        if constexpr (is_pool_policy)
+        {
+            policy.pool->ParallelFor(group_count, process_group);
+        }
+        else
+        {
+            std::vector<size_t> groups(group_count);
+            std::iota(groups.begin(), groups.end(), 0);
+            std::for_each(policy, groups.begin(), groups.end(), process_group);
+        }
+        MergePartialAccumulators(context, group_count);
+    }
+    else
+    {
+        for (size_t i = 0; i < query.plus_words.size(); ++i)
+        {
+            add_docs_by_plus_word(i, accumulator);
+        }
+    }
+
+    ExcludeMinusWordDocuments(query.minus_words, accumulator);
+}
+
+template <typename DocumentPredicate>
+void SearchServer::SearchPart(SearchContext& context, size_t part, DocumentPredicate document_predicate) const
 {
-    int TREAD_NUM = 1;
-    bool vectorize_plus_words = false;
-    if constexpr (std::is_same_v<ExecutionPolicy, std::execution::parallel_policy>)
+    const std::vector<std::string_view>& plus_words = context.plus_words_;
+    for (size_t i = part; i < plus_words.size(); i += context.part_count_)
     {
-        TREAD_NUM = 10;
-        vectorize_plus_words = true;
+        AddPlusWordDocuments(plus_words[i], document_predicate, nullptr, context.partial_accumulators_[part]);
     }
+}
 
-    ConcurrentMap<int, double> conc_map(TREAD_NUM);
-    
-    auto get_docs_by_plus_word = [this, &document_predicate, &conc_map](std::string_view word) {
-                                    
-        auto doc_freqs_it = word_to_document_freqs_.find(word);
-        if (doc_freqs_it == word_to_document_freqs_.end()) {
-            return;
+template <typename DocumentPredicate>
+void SearchServer::AddPlusWordDocuments(std::string_view word,
+                                        DocumentPredicate& document_predicate,
+                                        const double* inverse_document_freq,
+                                        ScoreAccumulator& accumulator) const
+{
+    const WordPostings* word_postings = FindWordPostings(word);
+    if (word_postings == nullptr) {
+        return;
+    }
+    const double word_inverse_document_freq = inverse_document_freq != nullptr
+        ? *inverse_document_freq
+        : ComputeWordInverseDocumentFreq(*word_postings);
+    const bool has_removed_slots = removed_slot_count_ > 0;
+    for (const auto [slot, term_freq] : word_postings->postings) 
+    {
+        if (has_removed_slots && removed_slots_[slot])
+        {
+            continue;
         }
-        const std::map<int, double>& doc_freqs = doc_freqs_it->second;
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : doc_freqs) 
+        if (document_predicate(slot_document_ids_[slot], slot_statuses_[slot], slot_ratings_[slot])) 
         {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) 
-            {
-                conc_map[document_id].ref_to_value += term_freq * inverse_document_freq;
-            }
+            accumulator.Add(slot, term_freq * word_inverse_document_freq);
         }
-    };
+    }
+}
 
-    if(vectorize_plus_words)
+template <typename Words>
+void SearchServer::ExcludeMinusWordDocuments(const Words& minus_words, ScoreAccumulator& accumulator) const
+{
+    for (std::string_view word : minus_words)
     {
-        std::vector<std::string_view> v_plus_words(query.plus_words.begin(), query.plus_words.end());
-        std::for_each(
-            policy,
-            v_plus_words.begin(), v_plus_words.end(),
-            get_docs_by_plus_word
-        );
+        const WordPostings* word_postings = FindWordPostings(word);
+        if (word_postings == nullptr) {
+            continue;
+        }
+        for (const auto [slot, _] : word_postings->postings) 
+        {
+            accumulator.Exclude(slot);
+        }
     }
-    else
+}
+
+template <typename DocumentPredicate>
+void SearchServer::FindTopDocumentsMaxScore(const SearchServer::Query& query,
+                                            DocumentPredicate document_predicate,
+                                            int offset,
+                                            int max_result_count,
+                                            SearchContext& context) const
+{
+    using TermCursor = SearchContext::TermCursor;
+
+    std::vector<Document>& heap = context.top_documents_;
+    heap.clear();
+    if (max_result_count == 0)
     {
-        std::for_each(
-            policy,
-            query.plus_words.begin(), query.plus_words.end(),
-            get_docs_by_plus_word
-        );
+        return;
     }
+    const size_t heap_size = static_cast<size_t>(offset) + static_cast<size_t>(max_result_count);
 
-    std::map<int, double> document_to_relevance = conc_map.BuildOrdinaryMap();   
-    
-    for_each(
-        query.minus_words.begin(), query.minus_words.end(),
-        [this, &document_to_relevance](std::string_view word){
-            auto doc_freqs_it = word_to_document_freqs_.find(word);
-        
-            if (doc_freqs_it == word_to_document_freqs_.end()) {
-                return;
+    std::vector<TermCursor>& cursors = context.cursors_;
+    cursors.clear();
+    for (std::string_view word : query.plus_words)
+    {
+        const WordPostings* word_postings = FindWordPostings(word);
+        if (word_postings == nullptr) {
+            continue;
+        }
+        const PostingList& postings = word_postings->postings;
+        const double inverse_document_freq = ComputeWordInverseDocumentFreq(*word_postings);
+        cursors.push_back({&postings, postings.begin(), postings.end(), inverse_document_freq, 
+                           postings.GetMaxTermFreq() * inverse_document_freq});
+    }
+
+    std::vector<TermCursor>& minus_cursors = context.minus_cursors_;
+    minus_cursors.clear();
+    for (std::string_view word : query.minus_words)
+    {
+        const WordPostings* word_postings = FindWordPostings(word);
+        if (word_postings == nullptr) {
+            continue;
+        }
+        const PostingList& postings = word_postings->postings;
+        minus_cursors.push_back({&postings, postings.begin(), postings.end(), 0.0, 0.0});
+    }
+
+    // Списки упорядочиваются по возрастанию верхней оценки вклада.
+    // prefix_max_scores[i] — верхняя оценка суммарного вклада списков [0, i]
+    std::sort(cursors.begin(), cursors.end(), [](const TermCursor& lhs, const TermCursor& rhs){
+        return lhs.max_score < rhs.max_score;
+    });
+    std::vector<double>& prefix_max_scores = context.prefix_max_scores_;
+    prefix_max_scores.resize(cursors.size());
+    double prefix_max_score = 0.0;
+    for (size_t i = 0; i < cursors.size(); ++i)
+    {
+        prefix_max_score += cursors[i].max_score;
+        prefix_max_scores[i] = prefix_max_score;
+    }
+
+    auto is_excluded = [&minus_cursors](int slot) {
+        for (TermCursor& cursor : minus_cursors)
+        {
+            if (cursor.it != cursor.end && cursor.it.GetDocumentId() < slot)
+            {
+                cursor.it = cursor.postings->Seek(cursor.it, slot);
             }
-            const auto& doc_freqs = doc_freqs_it->second;
-        
-            for (const auto [document_id, _] : doc_freqs) 
+            if (cursor.it != cursor.end && cursor.it.GetDocumentId() == slot)
             {
-                document_to_relevance.erase(document_id);
+                return true;
             }
- 
         }
-    );
+        return false;
+    };
 
-    std::vector<Document> matched_documents;
-        
-    for (const auto [document_id, relevance] : document_to_relevance) 
+    // Документ с оценкой ниже порога не может попасть в кучу даже с учётом RELEVANCE_ERROR
+    auto get_threshold = [&heap, heap_size]() {
+        return heap.size() < heap_size 
+            ? -std::numeric_limits<double>::infinity() 
+            : heap.front().relevance - RELEVANCE_ERROR;
+    };
+
+    // Слоты обходятся окнами: существенные списки [first_essential, n) суммируются в массив окна,
+    // а списки [0, first_essential) лишь дополняют оценку кандидатов окна по возрастанию слота
+    // Массивы окна обнуляются в начале запроса: предыдущий запрос с этим контекстом мог прерваться
+    // исключением предиката, не очистив окно. Внутри запроса отмеченная позиция очищается при разборе
+    constexpr int WINDOW_SIZE = 1024;
+    std::vector<double>& window_scores = context.window_scores_;
+    std::vector<uint8_t>& window_hits = context.window_hits_;
+    window_scores.assign(WINDOW_SIZE, 0.0);
+    window_hits.assign(WINDOW_SIZE, 0);
+
+    const int slot_count = static_cast<int>(slot_document_ids_.size());
+    size_t first_essential = 0;
+    for (int window_begin = 0; window_begin < slot_count; window_begin += WINDOW_SIZE)
     {
-        matched_documents.push_back(
-            {document_id, relevance, documents_.at(document_id).rating});
+        const double window_threshold = get_threshold();
+        while (first_essential < cursors.size() && prefix_max_scores[first_essential] < window_threshold)
+        {
+            ++first_essential;
+        }
+        if (first_essential == cursors.size())
+        {
+            break;
+        }
+
+        const int window_end = std::min(window_begin + WINDOW_SIZE, slot_count);
+        for (size_t i = first_essential; i < cursors.size(); ++i)
+        {
+            TermCursor& cursor = cursors[i];
+            for (; cursor.it != cursor.end && cursor.it.GetDocumentId() < window_end; ++cursor.it)
+            {
+                const int offset_in_window = cursor.it.GetDocumentId() - window_begin;
+                window_scores[offset_in_window] += cursor.it.GetTermFreq() * cursor.inverse_document_freq;
+                window_hits[offset_in_window] = 1;
+            }
+        }
+
+        for (int offset_in_window = 0; offset_in_window < window_end - window_begin; ++offset_in_window)
+        {
+            if (!window_hits[offset_in_window])
+            {
+                continue;
+            }
+            double relevance = window_scores[offset_in_window];
+            window_scores[offset_in_window] = 0.0;
+            window_hits[offset_in_window] = 0;
+
+            const int slot = window_begin + offset_in_window;
+            if (removed_slots_[slot] 
+                || !document_predicate(slot_document_ids_[slot], slot_statuses_[slot], slot_ratings_[slot]))
+            {
+                continue;
+            }
+
+            const double threshold = get_threshold();
+            bool is_pruned = false;
+            for (size_t i = first_essential; i-- > 0;)
+            {
+                if (relevance + prefix_max_scores[i] < threshold)
+                {
+                    is_pruned = true;
+                    break;
+                }
+                TermCursor& cursor = cursors[i];
+                if (cursor.it != cursor.end && cursor.it.GetDocumentId() < slot)
+                {
+                    cursor.it = cursor.postings->Seek(cursor.it, slot);
+                }
+                if (cursor.it != cursor.end && cursor.it.GetDocumentId() == slot)
+                {
+                    relevance += cursor.it.GetTermFreq() * cursor.inverse_document_freq;
+                }
+            }
+
+            if (is_pruned || relevance < threshold || is_excluded(slot))
+            {
+                continue;
+            }
+
+            PushTopDocument(heap, heap_size, {slot_document_ids_[slot], relevance, slot_ratings_[slot]});
+        }
     }
-    return matched_documents;
-}
 
+    FinishTopDocuments(heap, offset);
+}
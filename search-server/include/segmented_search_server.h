@@ -0,0 +1,356 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "document.h"
+#include "search_context.h"
+#include "search_server.h"
+#include "string_processing.h"
+
+// Документов в буфере записи, после которых он становится неизменяемым сегментом
+const size_t DEFAULT_WRITE_BUFFER_SIZE = 1000;
+// Число сегментов одного уровня размера, которые фоновое слияние объединяет за раз
+const size_t DEFAULT_MERGE_FACTOR = 4;
+
+// Индекс из неизменяемых сегментов и небольшого буфера записи (LSM-дерево).
+// Документ добавляется в буфер на месте, поэтому стоимость добавления не зависит от размера индекса;
+// заполненный буфер запечатывается в сегмент. Удаление документа из сегмента только помечает его
+// надгробием в наборе удалённых id сегмента. Фоновый поток сливает сегменты близкого размера в один,
+// физически отбрасывая удалённые документы.
+// Список сегментов публикуется атомарной заменой указателя, поэтому сегменты читаются без блокировок.
+// Буфер записи защищён разделяемой блокировкой: запрос ждёт только добавления одного документа в буфер,
+// а слияние сегментов не блокирует ни запросы, ни запись.
+// Релевантность считается по статистике живых документов всего индекса и совпадает с SearchServer
+// с теми же документами: надгробия вычитаются из числа документов и документных частот слов
+class SegmentedSearchServer {
+public:
+    template <typename StringContainer>
+    explicit SegmentedSearchServer(const StringContainer& stop_words,
+                                   size_t write_buffer_size = DEFAULT_WRITE_BUFFER_SIZE,
+                                   size_t merge_factor = DEFAULT_MERGE_FACTOR);
+
+    explicit SegmentedSearchServer(const std::string& stop_words_text,
+                                   size_t write_buffer_size = DEFAULT_WRITE_BUFFER_SIZE,
+                                   size_t merge_factor = DEFAULT_MERGE_FACTOR);
+
+    SegmentedSearchServer(const SegmentedSearchServer&) = delete;
+    SegmentedSearchServer& operator=(const SegmentedSearchServer&) = delete;
+
+    // Останавливает фоновое слияние, не дожидаясь запланированных слияний
+    ~SegmentedSearchServer();
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    // Пакет разбирается параллельно в отдельный индекс без блокировки писателей и публикуется целиком:
+    // пакет не меньше буфера записи становится сегментом, меньший переносится в буфер без повторного разбора.
+    // Если хотя бы один документ некорректен или уже добавлен, индекс не изменяется
+    void AddDocuments(const std::vector<DocumentToAdd>& documents);
+
+    void RemoveDocument(int document_id);
+    // Удаляет пакет документов и публикует одну новую версию индекса; отсутствующие id пропускаются
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    // Политика применяется к поиску в каждом сегменте; search_policy::max_score выполняется полным подсчётом.
+    // Окно выдачи [offset, offset + max_result_count) выбирается из лучших документов всех сегментов
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy,
+                                           std::string_view raw_query,
+                                           DocumentPredicate document_predicate,
+                                           int offset,
+                                           int max_result_count) const;
+    template <typename DocumentPredicate, typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy,
+                                           std::string_view raw_query,
+                                           DocumentPredicate document_predicate) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy,
+                                           std::string_view raw_query,
+                                           DocumentStatus status) const;
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(const ExecutionPolicy& policy, std::string_view raw_query) const;
+
+    // Совпадения ищутся в сегменте или буфере записи, где документ жив
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query,
+                                                                            int document_id) const;
+    template <typename ExecutionPolicy>
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const ExecutionPolicy& policy,
+                                                                            std::string_view raw_query,
+                                                                            int document_id) const;
+
+    int GetDocumentCount() const;
+
+    // Количество запечатанных сегментов без буфера записи
+    size_t GetSegmentCount() const;
+
+    // Запечатывает непустой буфер записи в сегмент
+    void Flush();
+
+    // Дожидается, пока фоновое слияние не обработает все сегменты, которые нужно слить
+    void WaitForMerges();
+
+    // Запечатывает буфер и сливает все сегменты в один, отбрасывая удалённые документы
+    void Compact();
+
+private:
+    // Неизменяемая порция надгробий: удалённые документы и число удалённых документов с каждым словом.
+    // Слова ссылаются на словарь сегмента
+    struct TombstoneChunk {
+        std::unordered_set<int> removed_ids;
+        std::unordered_map<std::string_view, int> removed_word_counts;
+    };
+
+    struct Segment {
+        std::shared_ptr<const SearchServer> index;
+        // Надгробия: документы сегмента, удалённые после его запечатывания. Порции разделяются
+        // версиями индекса, и каждая следующая не меньше чем вдвое меньше предыдущей, как разряды
+        // двоичного счётчика. Поэтому удаление k документов по одному копирует O(k log k) надгробий,
+        // а проверка документа и подсчёт слова просматривают O(log k) порций
+        std::vector<std::shared_ptr<const TombstoneChunk>> tombstones;
+        size_t removed_count = 0;
+
+        bool IsRemoved(int document_id) const;
+
+        // Число удалённых документов сегмента со словом
+        int CountRemovedWithWord(std::string_view word) const;
+    };
+
+    // Изменяемый буфер записи. После запечатывания буфер больше не изменяется и становится сегментом
+    struct WriteBuffer {
+        explicit WriteBuffer(const std::vector<std::string>& stop_words)
+            : index(stop_words)
+        {
+        }
+
+        SearchServer index;
+        mutable std::shared_mutex mutex;
+    };
+
+    // Версия индекса; сегменты и буфер записи разделяются соседними версиями
+    struct State {
+        std::vector<Segment> segments;
+        std::shared_ptr<WriteBuffer> write_buffer;
+    };
+
+    const std::vector<std::string> stop_words_;
+    const size_t write_buffer_size_;
+    const size_t merge_factor_;
+    // Буферы поиска общие для всех сегментов и возвращаются в пул после запроса
+    mutable SearchContextPool context_pool_;
+
+    // Защищает изменение state_ и флаги фонового слияния; запросы читают state_ без блокировки
+    mutable std::mutex writer_mutex_;
+    // Доступ только через std::atomic_load и std::atomic_store
+    std::shared_ptr<const State> state_;
+
+    // Слияния выполняются по одному: и фоновые, и вызванные Compact
+    std::mutex merge_mutex_;
+    std::condition_variable merge_requested_;
+    std::condition_variable merge_finished_;
+    bool is_merging_ = false;
+    bool is_stopping_ = false;
+    std::thread merger_;
+
+    std::shared_ptr<SearchServer> MakeEmptyIndex() const;
+
+    // Сегмент без надгробий
+    static Segment MakeSegment(std::shared_ptr<const SearchServer> index);
+
+    // Есть ли документ среди живых документов сегментов версии
+    static bool HasLiveSegmentDocument(const State& state, int document_id);
+
+    // Добавляет надгробия документов из document_ids, которые есть в сегменте и ещё не удалены.
+    // Возвращает false, если таких документов нет и сегмент не изменился
+    static bool AddTombstones(Segment& segment, const std::vector<int>& document_ids);
+
+    std::shared_ptr<const State> LoadState() const;
+
+    // Публикует новую версию; вызывается под writer_mutex_
+    void PublishState(State state);
+
+    // Сегменты одного уровня размера, которые пора слить, либо пустой вектор
+    std::vector<Segment> SelectSegmentsToMerge(const State& state) const;
+
+    bool IsMergeNeeded(const State& state) const;
+
+    // Под writer_mutex_ переносит буфер записи в сегменты и заводит новый
+    void SealWriteBuffer(State& state);
+
+    // Сливает сегменты в один, отбрасывая удалённые документы, и публикует результат.
+    // Вызывается под merge_mutex_, поэтому другое слияние не заменит эти сегменты до публикации
+    void MergeSegments(const std::vector<Segment>& segments);
+
+    void MergeLoop();
+};
+
+template <typename StringContainer>
+SegmentedSearchServer::SegmentedSearchServer(const StringContainer& stop_words,
+                                             size_t write_buffer_size,
+                                             size_t merge_factor)
+    : stop_words_(std::begin(stop_words), std::end(stop_words))
+    , write_buffer_size_(std::max<size_t>(write_buffer_size, 1))
+    , merge_factor_(std::max<size_t>(merge_factor, 2))
+{
+    // Проверка стоп-слов выполняется конструктором SearchServer
+    State state;
+    state.write_buffer = std::make_shared<WriteBuffer>(stop_words_);
+    state_ = std::make_shared<const State>(std::move(state));
+    merger_ = std::thread([this] { MergeLoop(); });
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(std::string_view raw_query,
+                                                              DocumentPredicate document_predicate) const
+{
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+                                                              std::string_view raw_query,
+                                                              DocumentPredicate document_predicate) const
+{
+    return FindTopDocuments(policy, raw_query, document_predicate, 0, MAX_RESULT_DOCUMENT_COUNT);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+                                                              std::string_view raw_query,
+                                                              DocumentStatus status) const
+{
+    return FindTopDocuments(policy, raw_query, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    });
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+                                                              std::string_view raw_query) const
+{
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename DocumentPredicate, typename ExecutionPolicy>
+std::vector<Document> SegmentedSearchServer::FindTopDocuments(const ExecutionPolicy& policy,
+                                                              std::string_view raw_query,
+                                                              DocumentPredicate document_predicate,
+                                                              int offset,
+                                                              int max_result_count) const
+{
+    if (max_result_count < 0)
+    {
+        throw std::invalid_argument("Количество документов в выдаче не может быть отрицательным"s);
+    }
+    if (offset < 0)
+    {
+        throw std::invalid_argument("Смещение в выдаче не может быть отрицательным"s);
+    }
+
+    const std::shared_ptr<const State> state = LoadState();
+    const SearchServer& write_buffer = state->write_buffer->index;
+    std::shared_lock write_buffer_lock(state->write_buffer->mutex);
+
+    // Запрос разбирается один раз: разбор зависит только от общих стоп-слов
+    const SearchServer::Query query = write_buffer.ParseQuery(raw_query);
+    if (max_result_count == 0)
+    {
+        return {};
+    }
+
+    // IDF считается по документным частотам и числу живых документов всех сегментов вместе
+    std::vector<int> document_freqs;
+    std::vector<int> segment_document_freqs;
+    int document_count = write_buffer.GetDocumentCount();
+    write_buffer.GetQueryDocumentFreqs(query, document_freqs);
+    for (const Segment& segment : state->segments)
+    {
+        document_count += segment.index->GetDocumentCount() - static_cast<int>(segment.removed_count);
+        segment.index->GetQueryDocumentFreqs(query, segment_document_freqs);
+        for (size_t i = 0; i < document_freqs.size(); ++i)
+        {
+            document_freqs[i] += segment_document_freqs[i];
+            if (segment.removed_count > 0 && segment_document_freqs[i] > 0)
+            {
+                document_freqs[i] -= segment.CountRemovedWithWord(query.plus_words[i]);
+            }
+        }
+    }
+    std::vector<double> inverse_document_freqs(document_freqs.size(), 0.0);
+    for (size_t i = 0; i < document_freqs.size(); ++i)
+    {
+        if (document_freqs[i] > 0)
+        {
+            inverse_document_freqs[i] = std::log(static_cast<double>(document_count))
+                                       - std::log(static_cast<double>(document_freqs[i]));
+        }
+    }
+
+    // Окно выдачи индекса находится среди offset + max_result_count лучших документов каждого сегмента
+    const int segment_result_count = static_cast<int>(std::min<int64_t>(
+        static_cast<int64_t>(offset) + max_result_count, std::numeric_limits<int>::max()));
+    const SearchContextPool::Handle context = context_pool_.Acquire();
+    std::vector<Document> result = write_buffer.FindTopDocumentsInSegment(
+        *context, policy, query, inverse_document_freqs, document_predicate, segment_result_count);
+    write_buffer_lock.unlock();
+    for (const Segment& segment : state->segments)
+    {
+        const auto& found = segment.index->FindTopDocumentsInSegment(
+            *context, policy, query, inverse_document_freqs,
+            [&segment, &document_predicate](int document_id, DocumentStatus status, int rating) {
+                return (segment.removed_count == 0 || !segment.IsRemoved(document_id))
+                    && document_predicate(document_id, status, rating);
+            },
+            segment_result_count);
+        result.insert(result.end(), found.begin(), found.end());
+    }
+
+    std::sort(result.begin(), result.end(), SearchServer::IsMoreRelevant);
+    result.erase(result.begin(), result.begin() + std::min(static_cast<size_t>(offset), result.size()));
+    if (result.size() > static_cast<size_t>(max_result_count))
+    {
+        result.resize(max_result_count);
+    }
+    return result;
+}
+
+template <typename ExecutionPolicy>
+std::tuple<std::vector<std::string_view>, DocumentStatus> SegmentedSearchServer::MatchDocument(
+    const ExecutionPolicy& policy, std::string_view raw_query, int document_id) const
+{
+    const std::shared_ptr<const State> state = LoadState();
+    {
+        std::shared_lock write_buffer_lock(state->write_buffer->mutex);
+        const SearchServer& write_buffer = state->write_buffer->index;
+        if (write_buffer.HasDocument(document_id))
+        {
+            return write_buffer.MatchDocument(policy, raw_query, document_id);
+        }
+    }
+    for (const Segment& segment : state->segments)
+    {
+        if (segment.index->HasDocument(document_id) && !segment.IsRemoved(document_id))
+        {
+            return segment.index->MatchDocument(policy, raw_query, document_id);
+        }
+    }
+    throw std::out_of_range("Документа с данным id не существует."s);
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Вектор с встроенным буфером на N элементов: пока элементов не больше N, память в куче
+// не выделяется. При переполнении все элементы переносятся в std::vector и остаются там до clear.
+// Элементы хранятся непрерывно, итераторы — обычные указатели. Предназначен для простых типов
+template <typename T, size_t N>
+class SmallVector {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>,
+                  "SmallVector хранит только простые типы");
+
+public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    SmallVector() = default;
+    SmallVector(const SmallVector&) = default;
+    SmallVector& operator=(const SmallVector&) = default;
+
+    // После перемещения исходный вектор пуст и снова хранит элементы во встроенном буфере
+    SmallVector(SmallVector&& other) noexcept
+        : SmallVector()
+    {
+        *this = std::move(other);
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept
+    {
+        if (this != &other)
+        {
+            std::copy(other.inline_items_, other.inline_items_ + (other.on_heap_ ? 0 : other.size_), inline_items_);
+            heap_items_ = std::move(other.heap_items_);
+            size_ = other.size_;
+            on_heap_ = other.on_heap_;
+            other.clear();
+        }
+        return *this;
+    }
+
+    void push_back(const T& value)
+    {
+        if (!on_heap_)
+        {
+            if (size_ < N)
+            {
+                inline_items_[size_++] = value;
+                return;
+            }
+            heap_items_.reserve(N * 2);
+            heap_items_.assign(inline_items_, inline_items_ + size_);
+            on_heap_ = true;
+        }
+        heap_items_.push_back(value);
+        ++size_;
+    }
+
+    // Удаляет элементы [first, last), сдвигая хвост
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        T* const position = begin() + (first - begin());
+        T* const new_end = std::copy(last, static_cast<const_iterator>(end()), position);
+        size_ = static_cast<size_t>(new_end - begin());
+        if (on_heap_)
+        {
+            heap_items_.resize(size_);
+        }
+        return position;
+    }
+
+    void clear()
+    {
+        heap_items_.clear();
+        on_heap_ = false;
+        size_ = 0;
+    }
+
+    T* data()
+    {
+        return on_heap_ ? heap_items_.data() : inline_items_;
+    }
+
+    const T* data() const
+    {
+        return on_heap_ ? heap_items_.data() : inline_items_;
+    }
+
+    iterator begin()
+    {
+        return data();
+    }
+
+    iterator end()
+    {
+        return data() + size_;
+    }
+
+    const_iterator begin() const
+    {
+        return data();
+    }
+
+    const_iterator end() const
+    {
+        return data() + size_;
+    }
+
+    T& operator[](size_t index)
+    {
+        return data()[index];
+    }
+
+    const T& operator[](size_t index) const
+    {
+        return data()[index];
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    // Хранятся ли элементы во встроенном буфере
+    bool IsInline() const
+    {
+        return !on_heap_;
+    }
+
+private:
+    T inline_items_[N] = {};
+    std::vector<T> heap_items_;
+    size_t size_ = 0;
+    bool on_heap_ = false;
+};
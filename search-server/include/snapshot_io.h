@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Запись снимка индекса в файл. Значения простых типов и массивы пишутся побайтно,
+// массив и строка предваряются количеством элементов. Порядок байтов — порядок байтов платформы.
+// Данные пишутся во временный файл, который заменяет целевой только в Finish,
+// поэтому прерванная запись не портит предыдущий снимок
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string& path);
+
+    template <typename T>
+    void WriteValue(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        WriteBytes(&value, sizeof(T));
+    }
+
+    template <typename T>
+    void WriteArray(const std::vector<T>& values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        WriteValue<uint64_t>(values.size());
+        WriteBytes(values.data(), values.size() * sizeof(T));
+    }
+
+    void WriteString(std::string_view text);
+
+    // Дописывает данные на диск и переименовывает временный файл в целевой
+    void Finish();
+
+private:
+    std::string path_;
+    std::string temp_path_;
+    std::ofstream out_;
+
+    void WriteBytes(const void* data, size_t size);
+};
+
+// Файл, отображённый в память только для чтения. Служит источником данных при загрузке снимка:
+// отображение освобождается вместе с объектом, и загруженный индекс на него не ссылается
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile();
+
+    const char* data() const
+    {
+        return data_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Последовательное чтение снимка из памяти. Массивы копируются в векторы одним блоком,
+// строки возвращаются представлениями исходной памяти.
+// Выход за границы данных означает повреждённый снимок и приводит к исключению
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t size);
+
+    template <typename T>
+    T ReadValue()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, ReadBytes(1, sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void ReadArray(std::vector<T>& values)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const uint64_t count = ReadValue<uint64_t>();
+        const char* bytes = ReadBytes(count, sizeof(T));
+        values.resize(count);
+        if (count > 0)
+        {
+            std::memcpy(values.data(), bytes, count * sizeof(T));
+        }
+    }
+
+    std::string_view ReadString();
+
+    bool AtEnd() const
+    {
+        return pos_ == end_;
+    }
+
+    size_t GetRemainingSize() const
+    {
+        return static_cast<size_t>(end_ - pos_);
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+
+    const char* ReadBytes(uint64_t count, size_t element_size);
+};
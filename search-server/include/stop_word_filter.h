@@ -0,0 +1,55 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// Неизменяемое множество стоп-слов, разложенное по длине слова. Слово длиннее самого длинного
+// стоп-слова или длины, которой нет среди стоп-слов, отвергается без обращения к данным.
+// Внутри группы одной длины слова упорядочены по ключу из первых 8 байт, поэтому слова
+// до 8 символов сравниваются одним целым числом, а хеш строки не вычисляется вовсе.
+// Фильтр хранит представления слов и не владеет их памятью
+class StopWordFilter {
+public:
+    StopWordFilter() = default;
+
+    // Повторы и пустые слова отбрасываются
+    explicit StopWordFilter(const std::vector<std::string_view>& words);
+
+    bool Contains(std::string_view word) const;
+
+    size_t size() const
+    {
+        return words_.size();
+    }
+
+    bool empty() const
+    {
+        return words_.empty();
+    }
+
+    auto begin() const
+    {
+        return words_.begin();
+    }
+
+    auto end() const
+    {
+        return words_.end();
+    }
+
+private:
+    // Границы группы слов одной длины в массивах keys_ и words_
+    struct LengthBucket {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+    };
+
+    static constexpr size_t KEY_SIZE = sizeof(uint64_t);
+
+    std::vector<LengthBucket> buckets_;
+    std::vector<uint64_t> keys_;
+    std::vector<std::string_view> words_;
+
+    static uint64_t MakeKey(std::string_view word);
+};
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+// Хранилище строк только на добавление. Строки копируются в крупные блоки памяти,
+// которые никогда не перемещаются и не освобождаются до уничтожения хранилища,
+// поэтому возвращённые string_view остаются валидными всё время его жизни.
+// Добавление строк потокобезопасно, чтение сохранённых строк не требует блокировок
+class StringArena {
+public:
+    explicit StringArena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    // Копирует строку в хранилище и возвращает представление копии
+    std::string_view Store(std::string_view text);
+
+private:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t block_size_;
+    char* current_ = nullptr;
+    size_t current_free_ = 0;
+};
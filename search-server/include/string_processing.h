@@ -6,6 +6,14 @@
 
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
+// Разбивает текст на слова, дописывая их в words. Позволяет переиспользовать память вектора
+void SplitIntoWords(std::string_view text, std::vector<std::string_view>& words);
+
+// Разбивает текст на слова за один проход и одновременно ищет управляющие символы (коды 0-31).
+// Возвращает false, если такие символы есть; слова при этом всё равно дописываются в words.
+// Текст обрабатывается блоками по 16 или 32 байта (SSE2 или AVX2, выбирается по процессору)
+bool SplitIntoWordsAndValidate(std::string_view text, std::vector<std::string_view>& words);
+
 template <typename StringContainer>
 std::unordered_set<std::string_view, std::hash<std::string_view>, std::equal_to<std::string_view>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
 
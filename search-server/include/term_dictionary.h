@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "snapshot_io.h"
+#include "string_arena.h"
+
+using TermId = uint32_t;
+
+// Словарь слов: каждому различному слову присваивается 32-битный номер в порядке появления.
+// Текст слова хранится один раз в StringArena, поиск номера по слову идёт по хеш-таблице
+// с открытой адресацией, в которой лежат только номера слов.
+// Копии словаря разделяют хранилище строк, поэтому их string_view остаются валидными
+class TermDictionary {
+public:
+    static constexpr TermId NO_TERM = std::numeric_limits<TermId>::max();
+
+    TermDictionary();
+
+    explicit TermDictionary(std::shared_ptr<StringArena> arena);
+
+    // Возвращает номер слова или NO_TERM, если слова нет в словаре
+    TermId Find(std::string_view word) const;
+
+    // Возвращает номер слова, добавляя его в словарь при необходимости
+    TermId Insert(std::string_view word);
+
+    std::string_view GetTerm(TermId term_id) const
+    {
+        return terms_[term_id];
+    }
+
+    size_t size() const
+    {
+        return terms_.size();
+    }
+
+    // Оставляет только слова с is_live[term_id] == true и нумерует их заново подряд в прежнем порядке.
+    // Строки переносятся в новое хранилище: память выброшенных слов освобождается вместе со старым
+    // хранилищем, когда его не используют копии словаря. Возвращает новые номера, NO_TERM для выброшенных
+    std::vector<TermId> Compact(const std::vector<bool>& is_live);
+
+    // Сохраняет слова в порядке номеров. Загрузка выполняется в пустой словарь
+    // и восстанавливает те же номера, таблица поиска строится заново
+    void Save(SnapshotWriter& writer) const;
+    void Load(SnapshotReader& reader);
+
+private:
+    std::shared_ptr<StringArena> arena_;
+    std::vector<std::string_view> terms_;
+    std::vector<TermId> table_;
+
+    // Позиция слова в таблице либо первая свободная позиция его цепочки проб
+    size_t FindPosition(std::string_view word) const;
+
+    // Готовит пустой словарь к вставке term_count слов без перестроения таблицы
+    void Reserve(size_t term_count);
+
+    void Grow();
+};
@@ -2,6 +2,8 @@
 #include <stdexcept>
 #include <iostream>
 #include <string>
+#include <vector>
+#include "document.h"
 
 using namespace std::string_literals;
 
@@ -51,6 +53,9 @@ void AssertImpl(bool value,
 
 #define ASSERT_HINT(expr, hint) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, (hint))
 
+// Проверяет, что выдачи совпадают по id и рейтингам документов, а релевантность — с точностью RELEVANCE_ERROR
+void AssertSameDocuments(const std::vector<Document>& actual, const std::vector<Document>& expected);
+
 // -------- Начало модульных тестов поисковой системы ----------
 
 // Тест проверяет, что поисковая система исключает стоп-слова при добавлении документов
@@ -83,6 +88,75 @@ void TestRelevanceValueIsCorrect();
 // Тестирование правильности удаления документа
 void TestRemoveDocument();
 
+// Тестирование упакованного списка вхождений слова
+void TestPostingList();
+
+// Тестирование накопителя релевантности и параллельного поиска на его основе
+void TestScoreAccumulator();
+
+// Тестирование ограничения количества документов в выдаче
+void TestMaxResultCount();
+
+// Тестирование совпадения выдачи MaxScore с полным подсчётом релевантности
+void TestMaxScorePolicy();
+
+// Тестирование пересчёта IDF после добавления и удаления документов
+void TestInverseDocumentFreqUpdates();
+
+// Тестирование словаря слов и частот слов документа
+void TestTermDictionary();
+
+// Тест проверяет, что стоп-слова не зависят от времени жизни переданных в конструктор строк
+void TestStopWordsOwnership();
+
+// Тестирование пакетного добавления документов
+void TestAddDocuments();
+
+// Тестирование сохранения сервера в снимок и загрузки из него
+void TestSnapshot();
+
+// Тестирование потоковой загрузки корпуса из файла
+void TestIngestCorpus();
+
+// Тестирование векторного разбиения текста на слова
+void TestSplitIntoWords();
+
+// Тестирование разбора запроса: повторы слов, стоп-слова и ошибки формата
+void TestParseQuery();
+
+// Тестирование вектора со встроенным буфером
+void TestSmallVector();
+
+// Тестирование фильтра стоп-слов
+void TestStopWordFilter();
+
+// Тестирование поиска с переиспользуемым контекстом
+void TestSearchContext();
+
+// Тестирование пула потоков и исполнителя пакетов запросов
+void TestQueryExecutor();
+
+// Тестирование объединённых результатов пакета запросов
+void TestProcessQueriesJoined();
+
+// Тестирование асинхронного поиска через исполнитель запросов
+void TestFindTopDocumentsAsync();
+
+// Тестирование изменения индекса во время выполнения запросов
+void TestConcurrentSearchServer();
+
+// Тестирование индекса из сегментов с фоновым слиянием
+void TestSegmentedSearchServer();
+
+// Тестирование отложенного удаления документов с последующей очисткой
+void TestDeferredRemoval();
+
+// Тестирование пакетного удаления документов
+void TestRemoveDocuments();
+
+// Тестирование поиска и удаления почти дубликатов
+void TestRemoveNearDuplicates();
+
 // Функция TestSearchServer является точкой входа для запуска тестов
 void TestSearchServer();
 
@@ -97,6 +171,9 @@ void TestDuplicates();
 // Функция проверяет правильность размера страницы при постраничном поиске
 void TestPageSize();
 
+// Функция проверяет, что ленивая постраничная выдача совпадает с выдачей по готовому результату
+void TestSearchPaginator();
+
 void TestPaginator();
 // -------- Окончание модульных тестов постраничной выдачи ----------
 
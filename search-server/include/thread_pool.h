@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с перехватом задач (work stealing). У каждого потока своя очередь: задачи,
+// порождённые внутри потока пула, кладутся в его очередь и берутся с того же конца,
+// а простаивающий поток забирает самые старые задачи из чужих очередей.
+// ParallelFor раздаёт номера итераций через общий счётчик вызова: вызывающий поток выполняет
+// только итерации своего вызова и не берёт посторонние задачи пула, поэтому вложенный
+// параллелизм (запрос внутри пакета, разделённый на части) не блокируется и не зависит
+// от содержимого очередей
+class ThreadPool {
+public:
+    // Пул содержит не менее одного потока
+    explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Дожидается выполнения всех поставленных задач и останавливает потоки
+    ~ThreadPool();
+
+    size_t GetThreadCount() const
+    {
+        return threads_.size();
+    }
+
+    void Submit(std::function<void()> task);
+
+    // Вызывает func(i) для каждого i из [0, count) на потоках пула и вызывающем потоке.
+    // Свободные потоки пула подключаются к вызову через задачи-помощники; разобрав итерации,
+    // вызывающий поток засыпает до завершения уже начатых. Возвращает управление после
+    // завершения всех вызовов; первое исключение пробрасывается
+    void ParallelFor(size_t count, const std::function<void(size_t)>& func);
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    static constexpr size_t NOT_A_WORKER = static_cast<size_t>(-1);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_up_;
+    std::atomic<size_t> pending_count_{0};
+    std::atomic<size_t> next_queue_{0};
+    bool is_stopping_ = false;
+
+    // Номер текущего потока в этом пуле либо NOT_A_WORKER
+    size_t GetWorkerIndex() const;
+
+    // Выполняет одну задачу: сначала из собственной очереди, затем перехваченную из чужой.
+    // Возвращает false, если задач не нашлось
+    bool TryRunTask(size_t worker_index);
+
+    void WorkerLoop(size_t worker_index);
+};
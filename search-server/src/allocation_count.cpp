@@ -0,0 +1,184 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <optional>
+#include "../include/allocation_count.h"
+
+using namespace std;
+
+#ifndef COUNT_ALLOCATIONS
+
+optional<size_t> GetAllocationCount()
+{
+    return nullopt;
+}
+
+#else
+
+// Все формы глобальных операторов new и delete заменены согласованно, чтобы бенчмарки
+// могли считать выделения памяти. Любая форма new выделяет память через malloc или aligned_alloc,
+// поэтому любая форма delete освобождает её через free.
+// Атомарный счётчик удорожает каждое выделение, поэтому замена собирается только с COUNT_ALLOCATIONS
+
+namespace {
+
+atomic<size_t> allocation_count{0};
+
+void* TryAllocate(size_t size, size_t alignment) noexcept
+{
+    size = size == 0 ? 1 : size;
+    void* ptr = nullptr;
+    if (alignment <= alignof(max_align_t))
+    {
+        ptr = malloc(size);
+    }
+    else
+    {
+        // aligned_alloc требует размера, кратного выравниванию
+        ptr = aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    }
+    if (ptr != nullptr)
+    {
+        allocation_count.fetch_add(1, memory_order_relaxed);
+    }
+    return ptr;
+}
+
+void* Allocate(size_t size, size_t alignment)
+{
+    while (true)
+    {
+        if (void* ptr = TryAllocate(size, alignment))
+        {
+            return ptr;
+        }
+        const new_handler handler = get_new_handler();
+        if (handler == nullptr)
+        {
+            throw bad_alloc();
+        }
+        handler();
+    }
+}
+
+void* AllocateNoThrow(size_t size, size_t alignment) noexcept
+{
+    try
+    {
+        return Allocate(size, alignment);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+}
+
+optional<size_t> GetAllocationCount()
+{
+    return allocation_count.load(memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+    return Allocate(size, alignof(max_align_t));
+}
+
+void* operator new[](size_t size)
+{
+    return Allocate(size, alignof(max_align_t));
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+    return AllocateNoThrow(size, alignof(max_align_t));
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept
+{
+    return AllocateNoThrow(size, alignof(max_align_t));
+}
+
+void* operator new(size_t size, align_val_t alignment)
+{
+    return Allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, align_val_t alignment)
+{
+    return Allocate(size, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept
+{
+    return AllocateNoThrow(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept
+{
+    return AllocateNoThrow(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, const nothrow_t&) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, const nothrow_t&) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t, align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t, align_val_t) noexcept
+{
+    free(ptr);
+}
+
+void operator delete(void* ptr, align_val_t, const nothrow_t&) noexcept
+{
+    free(ptr);
+}
+
+void operator delete[](void* ptr, align_val_t, const nothrow_t&) noexcept
+{
+    free(ptr);
+}
+
+#endif
@@ -1,9 +1,23 @@
 #include "../include/search_server.h"
 #include "../include/log_duration.h"
 #include "../include/process_queries.h"
+#include "../include/query_executor.h"
+#include "../include/concurrent_search_server.h"
+#include "../include/segmented_search_server.h"
+#include "../include/remove_duplicates.h"
 #include "../include/benchmarks.h"
+#include <algorithm>
 #include <execution>
+#include <filesystem>
+#include <future>
 #include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <sstream>
 #include <random>
 #include <string>
 #include <vector>
@@ -53,6 +67,17 @@ vector<string> GenerateQueries(mt19937& generator, const vector<string>& diction
     return queries;
 }
 
+// Среднее число выделений памяти на запрос либо пометка, что подсчёт выключен при сборке
+string FormatAllocationsPerQuery(optional<size_t> allocations_before, size_t query_count) {
+    const optional<size_t> allocations_after = GetAllocationCount();
+    if (!allocations_before || !allocations_after) {
+        return "n/a (build with COUNT_ALLOCATIONS)"s;
+    }
+    ostringstream out;
+    out << static_cast<double>(*allocations_after - *allocations_before) / query_count;
+    return out.str();
+}
+
 void BenchmarkRemoveDocument() {
 
     std::mt19937 generator;
@@ -67,6 +92,8 @@ void BenchmarkRemoveDocument() {
 
     LogDurationRemoveDocument("seq", search_server, std::execution::seq);
     LogDurationRemoveDocument("par", search_server, std::execution::par);
+    LogDurationRemoveDocuments("seq", search_server, std::execution::seq);
+    LogDurationRemoveDocuments("par", search_server, std::execution::par);
 }
 
 void BenchmarkFindTopDocuments() {
@@ -80,6 +107,7 @@ void BenchmarkFindTopDocuments() {
     const auto queries = GenerateQueries(generator, dictionary, 100, 70);
     LogDurationFindTopDocuments("seq"s, search_server, queries, std::execution::seq);
     LogDurationFindTopDocuments("par"s, search_server, queries, std::execution::par);
+    LogDurationFindTopDocuments("max_score"s, search_server, queries, search_policy::max_score);
 }
 
 void BenchmarkMatchDocument()
@@ -98,3 +126,298 @@ void BenchmarkMatchDocument()
     LogDurationMatchDocument("seq"s, search_server, query, std::execution::seq);
     LogDurationMatchDocument("par"s, search_server, query, std::execution::par);
 }
+
+void BenchmarkAddDocuments()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 10'000, 25);
+    const auto texts = GenerateQueries(generator, dictionary, 10'000, 100);
+
+    std::vector<DocumentToAdd> documents;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        documents.push_back({static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+    }
+
+    {
+        LOG_DURATION("AddDocument"s);
+        SearchServer search_server(dictionary[0]);
+        for (const DocumentToAdd& document : documents) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+        std::cout << search_server.GetDocumentCount() << std::endl;
+    }
+    {
+        LOG_DURATION("seq AddDocuments"s);
+        SearchServer search_server(dictionary[0]);
+        search_server.AddDocuments(std::execution::seq, documents);
+        std::cout << search_server.GetDocumentCount() << std::endl;
+    }
+    {
+        LOG_DURATION("par AddDocuments"s);
+        SearchServer search_server(dictionary[0]);
+        search_server.AddDocuments(std::execution::par, documents);
+        std::cout << search_server.GetDocumentCount() << std::endl;
+    }
+}
+
+void BenchmarkSnapshot()
+{
+    std::mt19937 generator;
+
+    const auto dictionary = GenerateDictionary(generator, 10'000, 25);
+    const auto texts = GenerateQueries(generator, dictionary, 10'000, 100);
+    const std::string path = (std::filesystem::temp_directory_path() / "search_server_benchmark.bin"s).string();
+
+    {
+        LOG_DURATION("Reindex"s);
+        SearchServer search_server(dictionary[0]);
+        for (size_t i = 0; i < texts.size(); ++i) {
+            search_server.AddDocument(i, texts[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        search_server.SaveSnapshot(path);
+        std::cout << search_server.GetDocumentCount() << std::endl;
+    }
+    {
+        LOG_DURATION("LoadSnapshot"s);
+        const SearchServer search_server = SearchServer::LoadSnapshot(path);
+        std::cout << search_server.GetDocumentCount() << std::endl;
+    }
+    std::filesystem::remove(path);
+}
+
+void BenchmarkSearchContext()
+{
+    std::mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    std::vector<std::string> queries;
+    for (int i = 0; i < 1000; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, 5, 0.1));
+    }
+
+    // Первый запрос прогревает буферы, выделения считаются по остальным
+    {
+        LOG_DURATION("FindTopDocuments"s);
+        double total_relevance = 0;
+        search_server.FindTopDocuments(queries[0]);
+        const optional<size_t> allocations_before = GetAllocationCount();
+        for (std::string_view query : queries) {
+            for (const auto& document : search_server.FindTopDocuments(query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        std::cout << total_relevance << ", allocations per query: "s 
+                  << FormatAllocationsPerQuery(allocations_before, queries.size()) << std::endl;
+    }
+    for (const bool use_max_score : {false, true}) {
+        LOG_DURATION((use_max_score ? "max_score "s : ""s) + "SearchContext FindTopDocuments"s);
+        SearchContext context;
+        const auto any_document = [](int, DocumentStatus status, int) { return status == DocumentStatus::ACTUAL; };
+        const auto find_top_documents = [&](std::string_view query) -> const std::vector<Document>& {
+            return use_max_score
+                ? search_server.FindTopDocuments(context, search_policy::max_score, query, any_document, 
+                                                 0, MAX_RESULT_DOCUMENT_COUNT)
+                : search_server.FindTopDocuments(context, query);
+        };
+
+        double total_relevance = 0;
+        find_top_documents(queries[0]);
+        const optional<size_t> allocations_before = GetAllocationCount();
+        for (std::string_view query : queries) {
+            for (const auto& document : find_top_documents(query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        std::cout << total_relevance << ", allocations per query: "s 
+                  << FormatAllocationsPerQuery(allocations_before, queries.size()) << std::endl;
+    }
+}
+
+void BenchmarkQueryExecutor()
+{
+    std::mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    // Каждый двадцатый запрос тяжёлый: на него приходится основная доля работы пакета
+    std::vector<std::string> queries;
+    for (int i = 0; i < 2000; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, i % 20 == 0 ? 200 : 5, 0.1));
+    }
+
+    const auto print_total_relevance = [](const std::vector<std::vector<Document>>& results) {
+        double total_relevance = 0;
+        for (const auto& documents : results) {
+            for (const auto& document : documents) {
+                total_relevance += document.relevance;
+            }
+        }
+        std::cout << total_relevance << std::endl;
+    };
+
+    {
+        LOG_DURATION("transform par ProcessQueries"s);
+        std::vector<std::vector<Document>> results(queries.size());
+        std::transform(std::execution::par, queries.begin(), queries.end(), results.begin(),
+                       [&search_server](const std::string& query) { return search_server.FindTopDocuments(query); });
+        print_total_relevance(results);
+    }
+    {
+        QueryExecutor executor;
+        LOG_DURATION("QueryExecutor ProcessQueries"s);
+        print_total_relevance(executor.ProcessQueries(search_server, queries));
+    }
+
+    // Объединение через промежуточные векторы и список против записи в общий буфер
+    QueryExecutor executor;
+    {
+        LOG_DURATION("list ProcessQueriesJoined"s);
+        std::list<Document> joined;
+        for (auto& documents : executor.ProcessQueries(search_server, queries)) {
+            std::move(documents.begin(), documents.end(), std::back_inserter(joined));
+        }
+        std::cout << joined.size() << std::endl;
+    }
+    {
+        LOG_DURATION("JoinedQueryResults ProcessQueriesJoined"s);
+        std::cout << executor.ProcessQueriesJoined(search_server, queries).size() << std::endl;
+    }
+    {
+        LOG_DURATION("FindTopDocumentsAsync"s);
+        std::vector<std::future<std::vector<Document>>> futures;
+        futures.reserve(queries.size());
+        for (const std::string& query : queries) {
+            futures.push_back(executor.FindTopDocumentsAsync(search_server, query));
+        }
+        std::vector<std::vector<Document>> results;
+        for (auto& future : futures) {
+            results.push_back(future.get());
+        }
+        print_total_relevance(results);
+    }
+}
+
+void BenchmarkSegmentedIndex()
+{
+    std::mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 5'000, 70);
+    std::vector<std::string> queries;
+    for (int i = 0; i < 1000; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, 5, 0.1));
+    }
+
+    // Обе структуры хранят индекс сегментами; пакет размером с буфер записи разбирается параллельно
+    // и сразу становится сегментом, а одиночные документы проходят через буфер записи
+    ConcurrentSearchServer concurrent_server(dictionary[0]);
+    {
+        LOG_DURATION("ConcurrentSearchServer AddDocuments by write buffer size"s);
+        std::vector<DocumentToAdd> batch;
+        for (size_t i = 0; i < documents.size(); ++i) {
+            batch.push_back({static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1, 2, 3}});
+            if (batch.size() == DEFAULT_WRITE_BUFFER_SIZE || i + 1 == documents.size()) {
+                concurrent_server.AddDocuments(batch);
+                batch.clear();
+            }
+        }
+    }
+    SegmentedSearchServer segmented_server(dictionary[0]);
+    {
+        LOG_DURATION("SegmentedSearchServer AddDocument"s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            segmented_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        segmented_server.WaitForMerges();
+    }
+    std::cout << "Segments: "s << segmented_server.GetSegmentCount() << std::endl;
+
+    {
+        LOG_DURATION("ConcurrentSearchServer FindTopDocuments"s);
+        double total_relevance = 0;
+        for (std::string_view query : queries) {
+            for (const auto& document : concurrent_server.FindTopDocuments(query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        std::cout << total_relevance << std::endl;
+    }
+    {
+        LOG_DURATION("SegmentedSearchServer FindTopDocuments"s);
+        double total_relevance = 0;
+        for (std::string_view query : queries) {
+            for (const auto& document : segmented_server.FindTopDocuments(query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        std::cout << total_relevance << std::endl;
+    }
+
+    // Удаление по одному публикует версию индекса на каждый документ, пакет — одну на все
+    const int half_count = static_cast<int>(documents.size()) / 2;
+    {
+        LOG_DURATION("SegmentedSearchServer RemoveDocument one by one"s);
+        for (int id = 0; id < half_count; ++id) {
+            segmented_server.RemoveDocument(id);
+        }
+    }
+    {
+        LOG_DURATION("SegmentedSearchServer RemoveDocuments"s);
+        std::vector<int> document_ids(documents.size() - half_count);
+        std::iota(document_ids.begin(), document_ids.end(), half_count);
+        segmented_server.RemoveDocuments(document_ids);
+    }
+    std::cout << "Documents after removal: "s << segmented_server.GetDocumentCount() << std::endl;
+}
+
+void BenchmarkRemoveDuplicates()
+{
+    std::mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 1000, 10);
+    const auto documents = GenerateQueries(generator, dictionary, 20'000, 30);
+    SearchServer search_server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    // Каждый десятый документ повторяет слова предыдущего в другом порядке
+    const int document_count = static_cast<int>(documents.size());
+    for (int i = 0; i < document_count; i += 10) {
+        std::string text;
+        for (const auto& [word, _] : search_server.GetWordFrequencies(i)) {
+            text = std::string(word) + " "s + text;
+        }
+        search_server.AddDocument(document_count + i, text, DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+
+    {
+        // Прежний подход: множество множеств слов, построенное по копиям частот слов
+        LOG_DURATION("set of word sets"s);
+        std::set<std::set<std::string>> word_sets;
+        int duplicate_count = 0;
+        for (const int document_id : search_server) {
+            std::set<std::string> words;
+            for (const auto& [word, _] : search_server.GetWordFrequencies(document_id)) {
+                words.emplace(word);
+            }
+            duplicate_count += word_sets.insert(std::move(words)).second ? 0 : 1;
+        }
+        std::cout << "Duplicates: "s << duplicate_count << std::endl;
+    }
+    {
+        LOG_DURATION("FindDuplicates"s);
+        std::cout << "Duplicates: "s << FindDuplicates(search_server).size() << std::endl;
+    }
+    {
+        LOG_DURATION("FindNearDuplicates"s);
+        std::cout << "Duplicates: "s << FindNearDuplicates(search_server).size() << std::endl;
+    }
+}
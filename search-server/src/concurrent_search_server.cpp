@@ -0,0 +1,39 @@
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/concurrent_search_server.h"
+
+using namespace std;
+
+ConcurrentSearchServer::ConcurrentSearchServer(const string& stop_words_text,
+                                               size_t write_buffer_size,
+                                               size_t merge_factor)
+    : index_(stop_words_text, write_buffer_size, merge_factor)
+{
+}
+
+int ConcurrentSearchServer::GetDocumentCount() const
+{
+    return index_.GetDocumentCount();
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings)
+{
+    index_.AddDocument(document_id, document, status, ratings);
+}
+
+void ConcurrentSearchServer::AddDocuments(const vector<DocumentToAdd>& documents)
+{
+    index_.AddDocuments(documents);
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id)
+{
+    index_.RemoveDocument(document_id);
+}
+
+void ConcurrentSearchServer::RemoveDocuments(const vector<int>& document_ids)
+{
+    index_.RemoveDocuments(document_ids);
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <execution>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "../include/corpus_ingestion.h"
+#include "../include/string_processing.h"
+
+using namespace std;
+
+namespace {
+
+int ParseCorpusNumber(string_view text)
+{
+    int value = 0;
+    const auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || error != errc() || end != text.data() + text.size())
+    {
+        throw invalid_argument("Ожидалось целое число: \""s + string(text) + "\""s);
+    }
+    return value;
+}
+
+DocumentStatus ParseCorpusStatus(string_view text)
+{
+    if (text == "ACTUAL"sv)
+    {
+        return DocumentStatus::ACTUAL;
+    }
+    if (text == "IRRELEVANT"sv)
+    {
+        return DocumentStatus::IRRELEVANT;
+    }
+    if (text == "BANNED"sv)
+    {
+        return DocumentStatus::BANNED;
+    }
+    if (text == "REMOVED"sv)
+    {
+        return DocumentStatus::REMOVED;
+    }
+    throw invalid_argument("Неизвестный статус документа: \""s + string(text) + "\""s);
+}
+
+// Отделяет от строки поле до табуляции
+string_view TakeCorpusField(string_view& line)
+{
+    const size_t tab = line.find('\t');
+    if (tab == string_view::npos)
+    {
+        throw invalid_argument("В строке корпуса должно быть четыре поля, разделённых табуляцией"s);
+    }
+    const string_view field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return field;
+}
+
+}
+
+DocumentToAdd ParseCorpusLine(string_view line)
+{
+    DocumentToAdd document;
+    document.id = ParseCorpusNumber(TakeCorpusField(line));
+    document.status = ParseCorpusStatus(TakeCorpusField(line));
+    for (string_view rating : SplitIntoWords(TakeCorpusField(line)))
+    {
+        document.ratings.push_back(ParseCorpusNumber(rating));
+    }
+    document.text = line;
+    return document;
+}
+
+size_t IngestCorpus(SearchServer& search_server, const string& path, size_t chunk_size)
+{
+    ifstream in(path, ios::binary);
+    if (!in)
+    {
+        throw runtime_error("Не удалось открыть файл корпуса: "s + path);
+    }
+
+    vector<char> buffer(max<size_t>(chunk_size, 1));
+    vector<DocumentToAdd> batch;
+    size_t carried_size = 0;
+    size_t line_number = 0;
+    size_t document_count = 0;
+
+    while (true)
+    {
+        // Незавершённая строка занимает весь буфер
+        if (carried_size == buffer.size())
+        {
+            buffer.resize(buffer.size() * 2);
+        }
+
+        in.read(buffer.data() + carried_size, static_cast<streamsize>(buffer.size() - carried_size));
+        if (in.bad())
+        {
+            throw runtime_error("Ошибка чтения файла корпуса: "s + path);
+        }
+        const size_t filled_size = carried_size + static_cast<size_t>(in.gcount());
+        const bool is_last_chunk = filled_size < buffer.size();
+        const string_view data(buffer.data(), filled_size);
+
+        // Разбираются только полные строки, хвост переносится в начало буфера.
+        // В последнем блоке полной считается и строка без перевода строки
+        batch.clear();
+        size_t line_start = 0;
+        while (line_start < data.size())
+        {
+            size_t line_end = data.find('\n', line_start);
+            if (line_end == string_view::npos)
+            {
+                if (!is_last_chunk)
+                {
+                    break;
+                }
+                line_end = data.size();
+            }
+
+            ++line_number;
+            string_view line = data.substr(line_start, line_end - line_start);
+            if (!line.empty() && line.back() == '\r')
+            {
+                line.remove_suffix(1);
+            }
+            if (!line.empty())
+            {
+                try
+                {
+                    batch.push_back(ParseCorpusLine(line));
+                }
+                catch (const invalid_argument& e)
+                {
+                    throw invalid_argument("Строка корпуса "s + to_string(line_number) + ": "s + e.what());
+                }
+            }
+            line_start = line_end + 1;
+        }
+
+        search_server.AddDocuments(execution::par, batch);
+        document_count += batch.size();
+
+        if (is_last_chunk)
+        {
+            break;
+        }
+        carried_size = filled_size - min(line_start, filled_size);
+        memmove(buffer.data(), buffer.data() + filled_size - carried_size, carried_size);
+    }
+
+    return document_count;
+}
@@ -41,6 +41,18 @@ int main() {
     BenchmarkMatchDocument();
     cout << "-------------------- BenchmarkRemoveDocument --------------------"s << endl;
     BenchmarkRemoveDocument();
+    cout << "-------------------- BenchmarkAddDocuments --------------------"s << endl;
+    BenchmarkAddDocuments();
+    cout << "-------------------- BenchmarkSnapshot --------------------"s << endl;
+    BenchmarkSnapshot();
+    cout << "-------------------- BenchmarkSearchContext --------------------"s << endl;
+    BenchmarkSearchContext();
+    cout << "-------------------- BenchmarkQueryExecutor --------------------"s << endl;
+    BenchmarkQueryExecutor();
+    cout << "-------------------- BenchmarkSegmentedIndex --------------------"s << endl;
+    BenchmarkSegmentedIndex();
+    cout << "-------------------- BenchmarkRemoveDuplicates --------------------"s << endl;
+    BenchmarkRemoveDuplicates();
     cout << endl;
 
  
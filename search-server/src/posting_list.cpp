@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <iterator>
+#include <vector>
+#include "../include/posting_list.h"
+
+using namespace std;
+
+namespace {
+
+[[noreturn]] void ThrowInconsistentPostings()
+{
+    throw runtime_error("Снимок индекса повреждён: несогласованный список вхождений"s);
+}
+
+}
+
+PostingList::Iterator::Iterator(const uint8_t* delta_pos, const uint8_t* delta_end, const double* freq_pos, 
+                                int prev_document_id)
+    : next_delta_pos_(delta_pos), delta_end_(delta_end), freq_pos_(freq_pos), document_id_(prev_document_id)
+{
+    if (next_delta_pos_ != delta_end_)
+    {
+        Decode();
+    }
+}
+
+PostingList::Iterator& PostingList::Iterator::operator++()
+{
+    ++freq_pos_;
+    if (next_delta_pos_ != delta_end_)
+    {
+        Decode();
+    }
+    return *this;
+}
+
+void PostingList::Iterator::Decode()
+{
+    document_id_ += static_cast<int>(ReadVarint(next_delta_pos_));
+}
+
+void PostingList::Add(int document_id, double term_freq)
+{
+    assert(freqs_.empty() || document_id > last_document_id_);
+    if (freqs_.size() % SKIP_INTERVAL == 0)
+    {
+        skips_.push_back({document_id, last_document_id_, static_cast<uint32_t>(deltas_.size())});
+    }
+    AppendVarint(deltas_, static_cast<uint32_t>(document_id - last_document_id_));
+    freqs_.push_back(term_freq);
+    last_document_id_ = document_id;
+    max_term_freq_ = std::max(max_term_freq_, term_freq);
+}
+
+PostingList::Iterator PostingList::begin() const
+{
+    return Iterator(deltas_.data(), deltas_.data() + deltas_.size(), freqs_.data());
+}
+
+PostingList::Iterator PostingList::end() const
+{
+    const uint8_t* deltas_end = deltas_.data() + deltas_.size();
+    return Iterator(deltas_end, deltas_end, freqs_.data() + freqs_.size());
+}
+
+PostingList::Iterator PostingList::Seek(Iterator from, int document_id) const
+{
+    const Iterator last = end();
+    if (from == last || from.document_id_ >= document_id)
+    {
+        return from;
+    }
+
+    // Если искомый id дальше текущего блока, переходим к последнему блоку, начинающемуся не дальше него
+    const size_t next_block = static_cast<size_t>(from.freq_pos_ - freqs_.data()) / SKIP_INTERVAL + 1;
+    if (next_block < skips_.size() && skips_[next_block].first_document_id <= document_id)
+    {
+        auto skip_it = upper_bound(skips_.begin() + next_block, skips_.end(), document_id, 
+                                   [](int id, const SkipEntry& skip){
+                                       return id < skip.first_document_id;
+                                   });
+        const SkipEntry& skip = *prev(skip_it);
+        const size_t skip_index = (prev(skip_it) - skips_.begin()) * SKIP_INTERVAL;
+        from = Iterator(deltas_.data() + skip.byte_offset, last.delta_end_, 
+                        freqs_.data() + skip_index, skip.prev_document_id);
+    }
+
+    while (from != last && from.document_id_ < document_id)
+    {
+        ++from;
+    }
+    return from;
+}
+
+void PostingList::AppendVarint(vector<uint8_t>& out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t PostingList::ReadVarint(const uint8_t*& pos)
+{
+    uint32_t value = 0;
+    int shift = 0;
+    while (*pos & 0x80)
+    {
+        value |= static_cast<uint32_t>(*pos & 0x7F) << shift;
+        shift += 7;
+        ++pos;
+    }
+    value |= static_cast<uint32_t>(*pos) << shift;
+    ++pos;
+    return value;
+}
+
+bool PostingList::TryReadVarint(const uint8_t*& pos, const uint8_t* end, uint32_t& value)
+{
+    // 32-битное значение занимает не больше пяти байт, в пятом используются только младшие четыре бита
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (pos == end)
+        {
+            return false;
+        }
+        const uint8_t byte = *pos++;
+        if (shift == 28 && (byte & 0xF0) != 0)
+        {
+            return false;
+        }
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void PostingList::Save(SnapshotWriter& writer) const
+{
+    writer.WriteArray(deltas_);
+    writer.WriteArray(freqs_);
+    writer.WriteArray(skips_);
+    writer.WriteValue(last_document_id_);
+    writer.WriteValue(max_term_freq_);
+}
+
+void PostingList::Load(SnapshotReader& reader)
+{
+    reader.ReadArray(deltas_);
+    reader.ReadArray(freqs_);
+    reader.ReadArray(skips_);
+    last_document_id_ = reader.ReadValue<int>();
+    max_term_freq_ = reader.ReadValue<double>();
+
+    if (skips_.size() != (freqs_.size() + SKIP_INTERVAL - 1) / SKIP_INTERVAL 
+        || deltas_.size() < freqs_.size())
+    {
+        ThrowInconsistentPostings();
+    }
+
+    const uint8_t* cur = deltas_.data();
+    const uint8_t* end = cur + deltas_.size();
+    int64_t prev_document_id = 0;
+    for (size_t index = 0; index < freqs_.size(); ++index)
+    {
+        const uint32_t byte_offset = static_cast<uint32_t>(cur - deltas_.data());
+        uint32_t delta = 0;
+        if (!TryReadVarint(cur, end, delta) || (index > 0 && delta == 0))
+        {
+            ThrowInconsistentPostings();
+        }
+        const int64_t document_id = prev_document_id + delta;
+        if (document_id > numeric_limits<int>::max() || !(freqs_[index] <= max_term_freq_))
+        {
+            ThrowInconsistentPostings();
+        }
+        if (index % SKIP_INTERVAL == 0)
+        {
+            const SkipEntry& skip = skips_[index / SKIP_INTERVAL];
+            if (skip.first_document_id != document_id || skip.prev_document_id != prev_document_id
+                || skip.byte_offset != byte_offset)
+            {
+                ThrowInconsistentPostings();
+            }
+        }
+        prev_document_id = document_id;
+    }
+    // Пустой список хранит исходные значения полей: иначе первая дельта Add посчиталась бы от мусора
+    const bool is_tail_consistent = freqs_.empty()
+        ? last_document_id_ == 0 && max_term_freq_ == 0.0
+        : prev_document_id == last_document_id_;
+    if (cur != end || !is_tail_consistent)
+    {
+        ThrowInconsistentPostings();
+    }
+}
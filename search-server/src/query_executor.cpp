@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "../include/query_executor.h"
+#include "../include/search_context.h"
+
+using namespace std;
+
+QueryExecutor::QueryExecutor(size_t thread_count, size_t heavy_query_word_count)
+    : heavy_query_word_count_(heavy_query_word_count)
+    , pool_(thread_count)
+{
+}
+
+vector<vector<Document>> QueryExecutor::ProcessQueries(const SearchServer& search_server,
+                                                       const vector<string>& queries)
+{
+    vector<vector<Document>> result(queries.size());
+    ForEachQueryResult(search_server, queries, [&result](size_t i, const vector<Document>& documents) {
+        result[i] = documents;
+    });
+    return result;
+}
+
+JoinedQueryResults QueryExecutor::ProcessQueriesJoined(const SearchServer& search_server,
+                                                       const vector<string>& queries)
+{
+    // Каждому запросу отводится участок буфера на максимальный размер выдачи,
+    // поэтому потоки пишут результаты сразу на место, не согласуя смещения
+    JoinedQueryResults result;
+    vector<Document>& documents = result.documents_;
+    vector<size_t>& offsets = result.offsets_;
+    documents.resize(queries.size() * MAX_RESULT_DOCUMENT_COUNT);
+    offsets.assign(queries.size() + 1, 0);
+
+    ForEachQueryResult(search_server, queries, [&](size_t i, const vector<Document>& found) {
+        copy(found.begin(), found.end(), documents.begin() + i * MAX_RESULT_DOCUMENT_COUNT);
+        offsets[i + 1] = found.size();
+    });
+
+    // Участки сдвигаются к началу буфера; новое место участка не правее прежнего.
+    // std::copy допускает перекрытие, только если начало приёмника лежит левее источника,
+    // а участок, оставшийся на месте, не копируется
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        const size_t source_offset = i * MAX_RESULT_DOCUMENT_COUNT;
+        if (offsets[i] != source_offset)
+        {
+            const auto source = documents.begin() + source_offset;
+            copy(source, source + offsets[i + 1], documents.begin() + offsets[i]);
+        }
+        offsets[i + 1] += offsets[i];
+    }
+    documents.resize(offsets.back());
+    return result;
+}
+
+void QueryExecutor::ForEachQueryResult(const SearchServer& search_server, const vector<string>& queries,
+                                       const function<void(size_t, const vector<Document>&)>& consume)
+{
+    if (queries.empty())
+    {
+        return;
+    }
+
+    const size_t task_count = min(queries.size(), pool_.GetThreadCount() * TASKS_PER_THREAD);
+    const size_t queries_per_task = (queries.size() + task_count - 1) / task_count;
+    const auto is_actual = [](int, DocumentStatus status, int) { return status == DocumentStatus::ACTUAL; };
+
+    pool_.ParallelFor(task_count, [&](size_t task) {
+        // Контекст берётся из пула сервера на порцию и возвращается после неё, не оставаясь за потоком
+        const SearchContextPool::Handle context = search_server.AcquireSearchContext();
+        const size_t end = min(queries.size(), (task + 1) * queries_per_task);
+        for (size_t i = task * queries_per_task; i < end; ++i)
+        {
+            if (IsHeavyQuery(queries[i]))
+            {
+                consume(i, search_server.FindTopDocuments(*context, search_policy::on(pool_), queries[i],
+                                                          is_actual, 0, MAX_RESULT_DOCUMENT_COUNT));
+            }
+            else
+            {
+                consume(i, search_server.FindTopDocuments(*context, queries[i]));
+            }
+        }
+    });
+}
+
+future<vector<Document>> QueryExecutor::FindTopDocumentsAsync(const SearchServer& search_server,
+                                                             string raw_query,
+                                                             DocumentStatus status)
+{
+    return FindTopDocumentsAsync(search_server, move(raw_query), [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    });
+}
+
+future<vector<Document>> QueryExecutor::FindTopDocumentsAsync(const SearchServer& search_server, string raw_query)
+{
+    return FindTopDocumentsAsync(search_server, move(raw_query), DocumentStatus::ACTUAL);
+}
+
+bool QueryExecutor::IsHeavyQuery(string_view query) const
+{
+    size_t word_count = 0;
+    bool in_word = false;
+    for (const char c : query)
+    {
+        if (c == ' ')
+        {
+            in_word = false;
+        }
+        else if (!in_word)
+        {
+            in_word = true;
+            if (++word_count >= heavy_query_word_count_)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -1,42 +1,312 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <execution>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+#include <vector>
 #include "../include/remove_duplicates.h"
-#include <iostream>
 
 using namespace std;
 
-void RemoveDuplicates(SearchServer& search_server) {
+namespace {
 
-    set<int> ids_to_del;
-    set<set<string>> uniq_words_by_docs;
-    set<string> all_words;
+// Число хеш-функций MinHash-подписи
+constexpr size_t SIGNATURE_SIZE = 64;
+// Допустимое число строк в полосе LSH: делители SIGNATURE_SIZE по убыванию
+constexpr array<size_t, 4> BAND_ROW_COUNTS = {8, 4, 2, 1};
+// Вероятность, с которой пара с пороговым сходством попадает в кандидаты
+constexpr double MIN_CANDIDATE_PROBABILITY = 0.99;
+// Сколько оставленных документов корзины и документов корзины из текущего блока проверяется
+// для каждого документа: ограничивает проверку большой корзины одинаковых документов
+constexpr size_t MAX_BUCKET_CANDIDATE_COUNT = 16;
+// Документы проверяются параллельно блоками; внутри блока решения согласуются последовательно
+constexpr size_t VERIFICATION_BLOCK_SIZE = 4096;
 
-    for (auto doc_id_it = search_server.begin(); doc_id_it != search_server.end(); ++doc_id_it)
+// Финализатор splitmix64: биекция, перемешивающая все биты
+uint64_t MixHash(uint64_t value)
+{
+    value += 0x9e3779b97f4a7c15;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+    return value ^ (value >> 31);
+}
+
+struct Fingerprint {
+    uint64_t low = 0;
+    uint64_t high = 0;
+
+    bool operator==(const Fingerprint& other) const
+    {
+        return low == other.low && high == other.high;
+    }
+};
+
+struct FingerprintHasher {
+    size_t operator()(const Fingerprint& fingerprint) const
+    {
+        return static_cast<size_t>(fingerprint.low);
+    }
+};
+
+// Ключ полосы MinHash-подписи документа с номером index
+struct BandEntry {
+    uint64_t key;
+    uint32_t index;
+    uint32_t band;
+};
+
+// Две независимые цепочки хешей по отсортированным номерам слов. Совпадение отпечатков
+// разных множеств среди n документов имеет вероятность порядка n^2 / 2^129
+Fingerprint ComputeFingerprint(const vector<TermId>& term_ids)
+{
+    Fingerprint fingerprint{MixHash(term_ids.size()), MixHash(~static_cast<uint64_t>(term_ids.size()))};
+    for (const TermId term_id : term_ids)
     {
-        auto words_freqs = search_server.GetWordFrequencies(*doc_id_it);
-        set<string> uniq_words;
-        for (const auto& [word, _] : words_freqs)
+        fingerprint.low = MixHash(fingerprint.low ^ term_id);
+        fingerprint.high = MixHash(fingerprint.high + (static_cast<uint64_t>(term_id) << 32 | term_id));
+    }
+    return fingerprint;
+}
+
+double ComputeJaccardSimilarity(const vector<TermId>& lhs, const vector<TermId>& rhs)
+{
+    if (lhs.empty() && rhs.empty())
+    {
+        return 1.0;
+    }
+    size_t common_count = 0;
+    for (auto lhs_it = lhs.begin(), rhs_it = rhs.begin(); lhs_it != lhs.end() && rhs_it != rhs.end();)
+    {
+        if (*lhs_it < *rhs_it)
         {
-            if(all_words.count(word) > 0)
-            {
-                uniq_words.emplace(word);
-            }
-            else
-            {
-                all_words.emplace(word);
-            }
+            ++lhs_it;
         }
-        
-        if (!uniq_words.empty() || uniq_words_by_docs.count(uniq_words) > 0)
+        else if (*rhs_it < *lhs_it)
         {
-            ids_to_del.emplace(*doc_id_it);
+            ++rhs_it;
         }
         else
         {
-            uniq_words_by_docs.emplace(uniq_words);
+            ++common_count;
+            ++lhs_it;
+            ++rhs_it;
+        }
+    }
+    return static_cast<double>(common_count) / static_cast<double>(lhs.size() + rhs.size() - common_count);
+}
+
+// Пара со сходством s попадает в кандидаты с вероятностью 1 - (1 - s^rows)^bands.
+// Выбираются самые длинные полосы, при которых пары с пороговым сходством почти не теряются:
+// чем длиннее полоса, тем меньше ложных кандидатов
+size_t SelectBandRowCount(double min_similarity)
+{
+    for (const size_t row_count : BAND_ROW_COUNTS)
+    {
+        const double band_count = static_cast<double>(SIGNATURE_SIZE / row_count);
+        const double miss_probability = pow(1.0 - pow(min_similarity, static_cast<double>(row_count)), band_count);
+        if (1.0 - miss_probability >= MIN_CANDIDATE_PROBABILITY)
+        {
+            return row_count;
+        }
+    }
+    return 1;
+}
+
+}
+
+vector<int> FindDuplicates(const SearchServer& search_server)
+{
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    vector<Fingerprint> fingerprints(document_ids.size());
+    vector<size_t> indexes(document_ids.size());
+    iota(indexes.begin(), indexes.end(), 0);
+    for_each(execution::par, indexes.begin(), indexes.end(), [&](size_t i) {
+        static thread_local vector<TermId> term_ids;
+        search_server.GetDocumentTermIds(document_ids[i], term_ids);
+        fingerprints[i] = ComputeFingerprint(term_ids);
+    });
+
+    // Документы просматриваются по возрастанию id, поэтому остаётся документ с наименьшим id
+    vector<int> duplicates;
+    unordered_set<Fingerprint, FingerprintHasher> seen_fingerprints;
+    seen_fingerprints.reserve(document_ids.size());
+    for (size_t i = 0; i < document_ids.size(); ++i)
+    {
+        if (!seen_fingerprints.insert(fingerprints[i]).second)
+        {
+            duplicates.push_back(document_ids[i]);
+        }
+    }
+    return duplicates;
+}
+
+vector<int> FindNearDuplicates(const SearchServer& search_server, double min_similarity)
+{
+    const size_t row_count = SelectBandRowCount(min_similarity);
+    const size_t band_count = SIGNATURE_SIZE / row_count;
+
+    // Хеш-функции подписи вида a * x + b над перемешанным номером слова: старшие биты результата
+    // образуют универсальное семейство, а вычисление стоит одного умножения
+    array<uint64_t, SIGNATURE_SIZE> multipliers;
+    array<uint64_t, SIGNATURE_SIZE> increments;
+    for (size_t j = 0; j < SIGNATURE_SIZE; ++j)
+    {
+        multipliers[j] = MixHash(2 * j) | 1;
+        increments[j] = MixHash(2 * j + 1);
+    }
+
+    // Для каждого документа хранятся только ключи полос подписи, а не вся подпись
+    const vector<int> document_ids(search_server.begin(), search_server.end());
+    vector<BandEntry> entries(document_ids.size() * band_count);
+    vector<size_t> indexes(document_ids.size());
+    iota(indexes.begin(), indexes.end(), 0);
+    for_each(execution::par, indexes.begin(), indexes.end(), [&](size_t i) {
+        static thread_local vector<TermId> term_ids;
+        search_server.GetDocumentTermIds(document_ids[i], term_ids);
+
+        array<uint64_t, SIGNATURE_SIZE> signature;
+        signature.fill(numeric_limits<uint64_t>::max());
+        for (const TermId term_id : term_ids)
+        {
+            const uint64_t term_hash = MixHash(term_id);
+            for (size_t j = 0; j < SIGNATURE_SIZE; ++j)
+            {
+                signature[j] = min(signature[j], term_hash * multipliers[j] + increments[j]);
+            }
         }
+
+        for (size_t band = 0; band < band_count; ++band)
+        {
+            uint64_t band_key = MixHash(band);
+            for (size_t j = band * row_count; j < (band + 1) * row_count; ++j)
+            {
+                band_key = MixHash(band_key ^ signature[j]);
+            }
+            entries[i * band_count + band] = {band_key, static_cast<uint32_t>(i), static_cast<uint32_t>(band)};
+        }
+    });
+
+    // Корзины LSH — отрезки равных ключей после сортировки; внутри корзины документы идут по возрастанию id
+    sort(execution::par, entries.begin(), entries.end(), [](const BandEntry& lhs, const BandEntry& rhs) {
+        return lhs.key < rhs.key || (lhs.key == rhs.key && lhs.index < rhs.index);
+    });
+    vector<size_t> entry_positions(entries.size());
+    vector<uint32_t> bucket_starts(entries.size());
+    for (size_t position = 0; position < entries.size(); ++position)
+    {
+        entry_positions[entries[position].index * band_count + entries[position].band] = position;
+        const bool is_bucket_start = position == 0 || entries[position - 1].key != entries[position].key;
+        bucket_starts[position] = is_bucket_start ? static_cast<uint32_t>(position) : bucket_starts[position - 1];
     }
-    for (int doc_id : ids_to_del)
+    const auto is_shared_bucket = [&entries](size_t bucket_start) {
+        return bucket_start + 1 < entries.size() && entries[bucket_start + 1].key == entries[bucket_start].key;
+    };
+
+    // Оставленные документы корзины хранятся на месте её записей: корзина с началом start занимает
+    // representatives[start, start + representative_counts[start]). Дубликаты в корзины не попадают,
+    // поэтому число сравнений не растёт с числом копий одного документа
+    vector<uint32_t> representatives(entries.size());
+    vector<uint8_t> representative_counts(entries.size(), 0);
+
+    // Документ сравнивается с оставленными документами прежних блоков из своих корзин и с первыми
+    // документами тех же корзин из своего блока. Сравнения блока выполняются параллельно,
+    // а затем решения принимаются по возрастанию id: документ — почти дубликат, если похож
+    // на оставленного кандидата
+    vector<int> duplicates;
+    vector<bool> is_duplicate(document_ids.size(), false);
+    vector<uint8_t> matches_representative(VERIFICATION_BLOCK_SIZE);
+    vector<vector<uint32_t>> similar_block_documents(VERIFICATION_BLOCK_SIZE);
+    for (size_t block_begin = 0; block_begin < document_ids.size(); block_begin += VERIFICATION_BLOCK_SIZE)
     {
-        search_server.RemoveDocument(doc_id);
+        const size_t block_end = min(document_ids.size(), block_begin + VERIFICATION_BLOCK_SIZE);
+        for_each(execution::par, indexes.begin() + block_begin, indexes.begin() + block_end, [&](size_t i) {
+            static thread_local vector<uint32_t> candidates;
+            static thread_local vector<uint32_t> block_candidates;
+            static thread_local vector<TermId> term_ids;
+            static thread_local vector<TermId> candidate_term_ids;
+            candidates.clear();
+            block_candidates.clear();
+            for (size_t band = 0; band < band_count; ++band)
+            {
+                const size_t position = entry_positions[i * band_count + band];
+                const size_t bucket_start = bucket_starts[position];
+                if (!is_shared_bucket(bucket_start))
+                {
+                    continue;
+                }
+                candidates.insert(candidates.end(), representatives.begin() + bucket_start,
+                                  representatives.begin() + bucket_start + representative_counts[bucket_start]);
+                // Внутри корзины записи упорядочены по номеру документа
+                auto block_it = partition_point(entries.begin() + bucket_start, entries.begin() + position,
+                                                [block_begin](const BandEntry& entry) { return entry.index < block_begin; });
+                for (size_t count = 0; block_it != entries.begin() + position && count < MAX_BUCKET_CANDIDATE_COUNT;
+                     ++block_it, ++count)
+                {
+                    block_candidates.push_back(block_it->index);
+                }
+            }
+
+            vector<uint32_t>& similar_documents = similar_block_documents[i - block_begin];
+            similar_documents.clear();
+            matches_representative[i - block_begin] = false;
+            if (candidates.empty() && block_candidates.empty())
+            {
+                return;
+            }
+            search_server.GetDocumentTermIds(document_ids[i], term_ids);
+            const auto is_similar = [&](uint32_t candidate) {
+                search_server.GetDocumentTermIds(document_ids[candidate], candidate_term_ids);
+                return ComputeJaccardSimilarity(term_ids, candidate_term_ids) >= min_similarity;
+            };
+
+            sort(candidates.begin(), candidates.end());
+            candidates.erase(unique(candidates.begin(), candidates.end()), candidates.end());
+            if (any_of(candidates.begin(), candidates.end(), is_similar))
+            {
+                matches_representative[i - block_begin] = true;
+                return;
+            }
+            sort(block_candidates.begin(), block_candidates.end());
+            block_candidates.erase(unique(block_candidates.begin(), block_candidates.end()), block_candidates.end());
+            copy_if(block_candidates.begin(), block_candidates.end(), back_inserter(similar_documents), is_similar);
+        });
+
+        for (size_t i = block_begin; i < block_end; ++i)
+        {
+            const vector<uint32_t>& similar_documents = similar_block_documents[i - block_begin];
+            if (matches_representative[i - block_begin]
+                || any_of(similar_documents.begin(), similar_documents.end(), [&is_duplicate](uint32_t candidate) {
+                       return !is_duplicate[candidate];
+                   }))
+            {
+                is_duplicate[i] = true;
+                duplicates.push_back(document_ids[i]);
+                continue;
+            }
+            for (size_t band = 0; band < band_count; ++band)
+            {
+                const size_t bucket_start = bucket_starts[entry_positions[i * band_count + band]];
+                uint8_t& representative_count = representative_counts[bucket_start];
+                if (is_shared_bucket(bucket_start) && representative_count < MAX_BUCKET_CANDIDATE_COUNT)
+                {
+                    representatives[bucket_start + representative_count++] = static_cast<uint32_t>(i);
+                }
+            }
+        }
     }
+    return duplicates;
+}
+
+void RemoveDuplicates(SearchServer& search_server)
+{
+    search_server.RemoveDocuments(execution::par, FindDuplicates(search_server));
 }
 
+void RemoveNearDuplicates(SearchServer& search_server, double min_similarity)
+{
+    search_server.RemoveDocuments(execution::par, FindNearDuplicates(search_server, min_similarity));
+}
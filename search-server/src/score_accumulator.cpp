@@ -0,0 +1,45 @@
+#include <vector>
+#include "../include/score_accumulator.h"
+
+using namespace std;
+
+ScoreAccumulator::ScoreAccumulator(size_t slot_count)
+    : scores_(slot_count, 0.0), states_(slot_count, SlotState::EMPTY)
+{
+}
+
+void ScoreAccumulator::Reset(size_t slot_count)
+{
+    for (int slot : touched_slots_)
+    {
+        scores_[slot] = 0.0;
+        states_[slot] = SlotState::EMPTY;
+    }
+    touched_slots_.clear();
+
+    // Массивы только растут: слоты за пределами slot_count уже обнулены и не затрагиваются,
+    // а сжатие заставило бы следующий поиск по большему серверу заново обнулять весь хвост
+    if (scores_.size() < slot_count)
+    {
+        scores_.resize(slot_count, 0.0);
+        states_.resize(slot_count, SlotState::EMPTY);
+    }
+}
+
+void ScoreAccumulator::Merge(const ScoreAccumulator& other)
+{
+    for (int slot : other.touched_slots_)
+    {
+        if (other.states_[slot] == SlotState::EXCLUDED)
+        {
+            if (states_[slot] == SlotState::EMPTY)
+            {
+                touched_slots_.push_back(slot);
+            }
+            states_[slot] = SlotState::EXCLUDED;
+            continue;
+        }
+
+        Add(slot, other.scores_[slot]);
+    }
+}
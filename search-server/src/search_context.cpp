@@ -0,0 +1,43 @@
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "../include/search_context.h"
+
+using namespace std;
+
+void SearchContextPool::Releaser::operator()(SearchContext* context) const
+{
+    if (pool_ == nullptr)
+    {
+        delete context;
+        return;
+    }
+    pool_->Release(context);
+}
+
+SearchContextPool::Handle SearchContextPool::Acquire()
+{
+    {
+        lock_guard guard(mutex_);
+        if (!idle_contexts_.empty())
+        {
+            Handle context(idle_contexts_.back().release(), Releaser(this));
+            idle_contexts_.pop_back();
+            return context;
+        }
+    }
+    return Handle(new SearchContext(), Releaser(this));
+}
+
+void SearchContextPool::Release(SearchContext* context)
+{
+    static const size_t max_idle_context_count = max(thread::hardware_concurrency(), 1u);
+
+    unique_ptr<SearchContext> released(context);
+    lock_guard guard(mutex_);
+    if (idle_contexts_.size() < max_idle_context_count)
+    {
+        idle_contexts_.push_back(move(released));
+    }
+}
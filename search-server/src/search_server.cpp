@@ -1,11 +1,28 @@
 #include <numeric>
+#include <functional>
 #include <stdexcept>
 #include <execution>
 #include <iostream>
+#include <exception>
+#include <mutex>
+#include <unordered_set>
 #include "../include/search_server.h"
 
 using namespace std;
 
+namespace {
+
+// "SRCHSNAP" в порядке байтов little-endian
+constexpr uint64_t SNAPSHOT_MAGIC = 0x50414E5348435253;
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+
+[[noreturn]] void ThrowCorruptedSnapshot(const string& reason)
+{
+    throw runtime_error("Снимок индекса повреждён: "s + reason);
+}
+
+}
+
 SearchServer::SearchServer(const std::string& stop_words_text) : SearchServer(SplitIntoWords(stop_words_text)) {}
 
 void SearchServer::AddDocument(int document_id, 
@@ -13,30 +30,268 @@ void SearchServer::AddDocument(int document_id,
                                 DocumentStatus status, 
                                 const vector<int>& ratings) {
     
+    CheckNewDocumentId(document_id);
+
+    // Буферы переиспользуются между вызовами: разбор документа не выделяет память на каждое слово
+    static thread_local vector<string_view> words;
+    static thread_local vector<TermId> term_ids;
+    words.clear();
+    term_ids.clear();
+
+    SplitIntoWordsNoStop(document, words);
+    for (string_view word : words){
+        term_ids.push_back(dictionary_.Insert(word));
+    }
+    sort(term_ids.begin(), term_ids.end());
+
+    const double inv_word_count = 1.0 / static_cast<int>(words.size());
+    const int slot = static_cast<int>(slot_document_ids_.size());
+
+    if (term_postings_.size() < dictionary_.size())
+    {
+        term_postings_.resize(dictionary_.size());
+    }
+
+    TermFreqs term_freqs;
+    for (auto it = term_ids.begin(); it != term_ids.end();){
+        const auto run_end = upper_bound(it, term_ids.end(), *it);
+        const double term_freq = (run_end - it) * inv_word_count;
+        term_freqs.emplace_back(*it, term_freq);
+
+        WordPostings& word_postings = term_postings_[*it];
+        word_postings.postings.Add(slot, term_freq);
+        ++word_postings.document_freq;
+        word_postings.UpdateDocumentFreq();
+        it = run_end;
+    }
+
+    AppendSlot(document_id, status, ComputeAverageRating(ratings), move(term_freqs));
+    UpdateDocumentCount();
+}
+
+void SearchServer::AddDocuments(const vector<DocumentToAdd>& documents)
+{
+    AddDocumentsImpl(execution::seq, documents);
+}
+
+void SearchServer::AddDocuments(execution::sequenced_policy, const vector<DocumentToAdd>& documents)
+{
+    AddDocumentsImpl(execution::seq, documents);
+}
+
+void SearchServer::AddDocuments(execution::parallel_policy, const vector<DocumentToAdd>& documents)
+{
+    AddDocumentsImpl(execution::par, documents);
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::AddDocumentsImpl(const ExecutionPolicy& policy, const vector<DocumentToAdd>& documents)
+{
+    unordered_set<int> batch_ids;
+    for (const DocumentToAdd& document : documents)
+    {
+        CheckNewDocumentId(document.id);
+        if (!batch_ids.insert(document.id).second)
+        {
+            throw invalid_argument("Документ с таким ID уже добавлен"s);
+        }
+    }
+
+    // Разбор текстов и поиск известных слов независимы для каждого документа. Исключение внутри
+    // параллельного алгоритма завершает программу, поэтому первая ошибка сохраняется и пробрасывается после
+    vector<pair<vector<string_view>, vector<TermId>>> parsed(documents.size());
+    vector<size_t> indexes(documents.size());
+    iota(indexes.begin(), indexes.end(), 0);
+
+    exception_ptr error;
+    mutex error_mutex;
+    for_each(policy, indexes.begin(), indexes.end(), [&](size_t i){
+        try
+        {
+            auto& [words, term_ids] = parsed[i];
+            SplitIntoWordsNoStop(documents[i].text, words);
+            term_ids.reserve(words.size());
+            for (string_view word : words)
+            {
+                term_ids.push_back(dictionary_.Find(word));
+            }
+        }
+        catch (...)
+        {
+            lock_guard guard(error_mutex);
+            if (!error)
+            {
+                error = current_exception();
+            }
+        }
+    });
+    if (error)
+    {
+        rethrow_exception(error);
+    }
+
+    // Новые слова добавляются в словарь последовательно
+    for (auto& [words, term_ids] : parsed)
+    {
+        for (size_t i = 0; i < term_ids.size(); ++i)
+        {
+            if (term_ids[i] == TermDictionary::NO_TERM)
+            {
+                term_ids[i] = dictionary_.Insert(words[i]);
+            }
+        }
+    }
+
+    vector<TermFreqs> term_freqs(documents.size());
+    for_each(policy, indexes.begin(), indexes.end(), [&](size_t i){
+        auto& [words, term_ids] = parsed[i];
+        sort(term_ids.begin(), term_ids.end());
+        const double inv_word_count = 1.0 / static_cast<int>(words.size());
+        for (auto it = term_ids.begin(); it != term_ids.end();)
+        {
+            const auto run_end = upper_bound(it, term_ids.end(), *it);
+            term_freqs[i].emplace_back(*it, (run_end - it) * inv_word_count);
+            it = run_end;
+        }
+        parsed[i] = {};
+    });
+
+    if (term_postings_.size() < dictionary_.size())
+    {
+        term_postings_.resize(dictionary_.size());
+    }
+
+    // Вхождения группируются по словам подсчётом: участок каждого слова упорядочен по слотам,
+    // поэтому списки вхождений разных слов пополняются параллельно и только дозаписью в конец
+    const int first_slot = static_cast<int>(slot_document_ids_.size());
+    vector<size_t> term_offsets(dictionary_.size() + 1, 0);
+    for (const TermFreqs& document_term_freqs : term_freqs)
+    {
+        for (const auto& [term_id, term_freq] : document_term_freqs)
+        {
+            ++term_offsets[term_id + 1];
+        }
+    }
+
+    vector<TermId> batch_terms;
+    for (TermId term_id = 0; term_id < dictionary_.size(); ++term_id)
+    {
+        if (term_offsets[term_id + 1] > 0)
+        {
+            batch_terms.push_back(term_id);
+        }
+    }
+    partial_sum(term_offsets.begin(), term_offsets.end(), term_offsets.begin());
+
+    vector<pair<int, double>> grouped_postings(term_offsets.back());
+    vector<size_t> fill_positions(term_offsets.begin(), term_offsets.end() - 1);
+    for (size_t i = 0; i < term_freqs.size(); ++i)
+    {
+        for (const auto& [term_id, term_freq] : term_freqs[i])
+        {
+            grouped_postings[fill_positions[term_id]++] = {first_slot + static_cast<int>(i), term_freq};
+        }
+    }
+
+    for_each(policy, batch_terms.begin(), batch_terms.end(), [&](TermId term_id){
+        WordPostings& word_postings = term_postings_[term_id];
+        for (size_t i = term_offsets[term_id]; i < term_offsets[term_id + 1]; ++i)
+        {
+            word_postings.postings.Add(grouped_postings[i].first, grouped_postings[i].second);
+        }
+        word_postings.document_freq += static_cast<int>(term_offsets[term_id + 1] - term_offsets[term_id]);
+        word_postings.UpdateDocumentFreq();
+    });
+
+    for (size_t i = 0; i < documents.size(); ++i)
+    {
+        AppendSlot(documents[i].id, documents[i].status, ComputeAverageRating(documents[i].ratings), move(term_freqs[i]));
+    }
+    UpdateDocumentCount();
+}
+
+void SearchServer::CheckNewDocumentId(int document_id) const
+{
     if (document_id < 0)
     {
         throw invalid_argument("ID документа должен быть положительным"s);
     }
 
-    if (documents_.count(document_id) > 0)
+    if (document_to_slot_.count(document_id) > 0)
     {
         throw invalid_argument("Документ с таким ID уже добавлен"s);
     }
+}
 
-    vector<string_view> words = SplitIntoWordsNoStop(document);
-    map<string, double, std::less<>> words_freeqs;
-    
-    const double inv_word_count = 1.0 / static_cast<int>(words.size());
-    
-    for (string_view word : words){
-        word_to_document_freqs_[std::string{word}][document_id] += inv_word_count;
-        words_freeqs[std::string{word}] += inv_word_count;
+void SearchServer::AppendSlot(int document_id, DocumentStatus status, int rating, TermFreqs term_freqs)
+{
+    const int slot = static_cast<int>(slot_document_ids_.size());
+    document_to_slot_.emplace(document_id, slot);
+    slot_document_ids_.push_back(document_id);
+    slot_ratings_.push_back(rating);
+    slot_statuses_.push_back(status);
+    slot_term_freqs_.push_back(move(term_freqs));
+    removed_slots_.push_back(false);
+    doc_ids_.insert(document_id);
+}
+
+void SearchServer::AppendDocuments(const SearchServer& source, const function<bool(int)>& is_removed)
+{
+    // Номера слов источника переводятся в номера этого словаря по мере появления
+    vector<TermId> term_ids(source.dictionary_.size(), TermDictionary::NO_TERM);
+    for (size_t source_slot = 0; source_slot < source.slot_document_ids_.size(); ++source_slot)
+    {
+        const int document_id = source.slot_document_ids_[source_slot];
+        const auto slot_it = source.document_to_slot_.find(document_id);
+        if (slot_it == source.document_to_slot_.end() || slot_it->second != static_cast<int>(source_slot)
+            || is_removed(document_id))
+        {
+            continue;
+        }
+        CheckNewDocumentId(document_id);
+
+        TermFreqs term_freqs;
+        term_freqs.reserve(source.slot_term_freqs_[source_slot].size());
+        for (const auto& [source_term_id, term_freq] : source.slot_term_freqs_[source_slot])
+        {
+            if (term_ids[source_term_id] == TermDictionary::NO_TERM)
+            {
+                term_ids[source_term_id] = dictionary_.Insert(source.dictionary_.GetTerm(source_term_id));
+            }
+            term_freqs.emplace_back(term_ids[source_term_id], term_freq);
+        }
+        sort(term_freqs.begin(), term_freqs.end());
+
+        if (term_postings_.size() < dictionary_.size())
+        {
+            term_postings_.resize(dictionary_.size());
+        }
+        const int slot = static_cast<int>(slot_document_ids_.size());
+        for (const auto& [term_id, term_freq] : term_freqs)
+        {
+            WordPostings& word_postings = term_postings_[term_id];
+            word_postings.postings.Add(slot, term_freq);
+            ++word_postings.document_freq;
+            word_postings.UpdateDocumentFreq();
+        }
+        AppendSlot(document_id, source.slot_statuses_[source_slot], source.slot_ratings_[source_slot], move(term_freqs));
     }
+    UpdateDocumentCount();
+}
 
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
-    doc_ids_.insert(document_id);
-    
-    doc_to_words_freeqs_[document_id] = words_freeqs;
+bool SearchServer::HasDocument(int document_id) const
+{
+    return document_to_slot_.count(document_id) > 0;
+}
+
+void SearchServer::GetQueryDocumentFreqs(const Query& query, vector<int>& document_freqs) const
+{
+    document_freqs.clear();
+    for (string_view word : query.plus_words)
+    {
+        const WordPostings* word_postings = FindWordPostings(word);
+        document_freqs.push_back(word_postings == nullptr ? 0 : word_postings->document_freq);
+    }
 }
 
 vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, 
@@ -48,9 +303,72 @@ vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) cons
     return FindTopDocuments(std::execution::seq, raw_query);
 }
 
+const vector<Document>& SearchServer::FindTopDocuments(SearchContext& context, 
+                                                       string_view raw_query, 
+                                                       DocumentStatus status) const {
+    return FindTopDocuments(context, raw_query, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    });
+}
+
+const vector<Document>& SearchServer::FindTopDocuments(SearchContext& context, string_view raw_query) const {
+    return FindTopDocuments(context, raw_query, DocumentStatus::ACTUAL);
+}
+
+size_t SearchServer::StartPartitionedSearch(SearchContext& context, string_view raw_query, size_t max_part_count) const
+{
+    const Query query = ParseQuery(raw_query);
+    context.plus_words_.assign(query.plus_words.begin(), query.plus_words.end());
+    context.minus_words_.assign(query.minus_words.begin(), query.minus_words.end());
+    context.part_count_ = max<size_t>(1, min({context.plus_words_.size(), max_part_count, MAX_QUERY_GROUP_COUNT}));
+    ResetPartialAccumulators(context, context.part_count_);
+    return context.part_count_;
+}
+
+const vector<Document>& SearchServer::FinishPartitionedSearch(SearchContext& context,
+                                                              int offset,
+                                                              int max_result_count) const
+{
+    if (max_result_count < 0)
+    {
+        throw invalid_argument("Количество документов в выдаче не может быть отрицательным"s);
+    }
+    if (offset < 0)
+    {
+        throw invalid_argument("Смещение в выдаче не может быть отрицательным"s);
+    }
+    MergePartialAccumulators(context, context.part_count_);
+    ExcludeMinusWordDocuments(context.minus_words_, context.accumulator_);
+    SelectTopDocuments(context.accumulator_, offset, max_result_count, context.top_documents_);
+    return context.top_documents_;
+}
+
+void SearchServer::ResetPartialAccumulators(SearchContext& context, size_t part_count) const
+{
+    vector<ScoreAccumulator>& partial_accumulators = context.partial_accumulators_;
+    if (partial_accumulators.size() < part_count)
+    {
+        partial_accumulators.resize(part_count);
+    }
+    for (size_t part = 0; part < part_count; ++part)
+    {
+        partial_accumulators[part].Reset(slot_document_ids_.size());
+    }
+}
+
+void SearchServer::MergePartialAccumulators(SearchContext& context, size_t part_count)
+{
+    // Накопитель первой части становится итоговым, буферы обоих остаются в контексте
+    swap(context.accumulator_, context.partial_accumulators_[0]);
+    for (size_t part = 1; part < part_count; ++part)
+    {
+        context.accumulator_.Merge(context.partial_accumulators_[part]);
+    }
+}
+
 
 int SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return doc_ids_.size();
 }
 
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(string_view raw_query, int document_id) const {
@@ -59,7 +377,7 @@ tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(string_vi
 }
 
 bool SearchServer::IsStopWord(string_view word) const {
-    return stop_words_.count(word) > 0;
+    return stop_words_.Contains(word);
 }
 
 bool SearchServer::IsValidWord(string_view word)
@@ -68,21 +386,19 @@ bool SearchServer::IsValidWord(string_view word)
 }
 
     
-vector<string_view> SearchServer::SplitIntoWordsNoStop(string_view text) const {
-    vector<string_view> words;
-    
-    vector<string_view> splited_by_words = SplitIntoWords(text);
+void SearchServer::SplitIntoWordsNoStop(string_view text, vector<string_view>& words) const {
+    static thread_local vector<string_view> splited_by_words;
+    splited_by_words.clear();
+    if (!SplitIntoWordsAndValidate(text, splited_by_words))
+    {
+        throw invalid_argument("Документ не должен содержать спецсимволы"s);
+    }
 
     for (string_view word : splited_by_words) {
         if (!IsStopWord(word)) {
             words.push_back(word);
         }
-        if (!IsValidWord(word))
-        {
-            throw invalid_argument("Документ не должен содержать спецсимволы"s);
-        }
     }
-    return words;
 }
 
 int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
@@ -94,82 +410,192 @@ int SearchServer::ComputeAverageRating(const vector<int>& ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text) const {
-    bool is_minus = false;
-
-    if (!IsValidWord(text))
+SearchServer::Query SearchServer::ParseQuery(string_view text) const {
+        
+    static thread_local vector<string_view> splited_by_words;
+    splited_by_words.clear();
+    if (!SplitIntoWordsAndValidate(text, splited_by_words))
     {
         throw invalid_argument("Слово запроса не должно содержать спецсимволы"s);
     }
-            
-    if (text[0] == '-') {
-        is_minus = true;
-        
-        text.remove_prefix(1);
-        if (text.empty())
+    
+    Query query;
+    for (string_view word : splited_by_words) {
+        const bool is_minus = word[0] == '-';
+        if (is_minus)
         {
-            throw invalid_argument("После знака \"-\" в запросе должно быть минус слово"s);
+            word.remove_prefix(1);
+            if (word.empty())
+            {
+                throw invalid_argument("После знака \"-\" в запросе должно быть минус слово"s);
+            }
+            if (word[0] == '-')
+            {
+                throw invalid_argument("Использование выражения \"--\" в запросе недопустимо"s);
+            }
         }
-        else if (text[0] == '-')
+
+        if (!IsStopWord(word))
         {
-            throw invalid_argument("Использование выражения \"--\" в запросе недопустимо"s);
+            (is_minus ? query.minus_words : query.plus_words).push_back(word);
         }
     }
 
-    return {text, is_minus, IsStopWord(text)};
+    for (QueryWords* words : {&query.plus_words, &query.minus_words})
+    {
+        sort(words->begin(), words->end());
+        words->erase(unique(words->begin(), words->end()), words->end());
+    }
+    
+    return query;
 }
 
-SearchServer::Query SearchServer::ParseQuery(string_view text) const {
-        
-    Query query;
-    vector<string_view> splited_by_words = SplitIntoWords(text);
-    
-    for (string_view word : splited_by_words) {
-        QueryWord query_word = ParseQueryWord(word);
 
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                query.minus_words.insert(query_word.data);
-            } else {
-                query.plus_words.insert(query_word.data);
-            }
+void SearchServer::UpdateDocumentCount()
+{
+    log_document_count_ = log(static_cast<double>(doc_ids_.size()));
+}
+
+const SearchServer::WordPostings* SearchServer::FindWordPostings(string_view word) const
+{
+    const TermId term_id = dictionary_.Find(word);
+    if (term_id == TermDictionary::NO_TERM || term_postings_[term_id].document_freq == 0)
+    {
+        return nullptr;
+    }
+    return &term_postings_[term_id];
+}
+
+bool SearchServer::DocumentContainsWord(int slot, string_view word) const
+{
+    const TermId term_id = dictionary_.Find(word);
+    if (term_id == TermDictionary::NO_TERM)
+    {
+        return false;
+    }
+    const TermFreqs& term_freqs = slot_term_freqs_[slot];
+    const auto it = lower_bound(term_freqs.begin(), term_freqs.end(), term_id, 
+                                [](const pair<TermId, double>& item, TermId id){
+                                    return item.first < id;
+                                });
+    return it != term_freqs.end() && it->first == term_id;
+}
+
+bool SearchServer::IsMoreRelevant(const Document& lhs, const Document& rhs)
+{
+    if (std::abs(lhs.relevance - rhs.relevance) < RELEVANCE_ERROR) 
+    {
+        if (lhs.rating != rhs.rating)
+        {
+            return lhs.rating > rhs.rating;
         }
+        return lhs.id < rhs.id;
     }
-    
-    return query;
+    return lhs.relevance > rhs.relevance;
 }
 
+void SearchServer::SelectTopDocuments(const ScoreAccumulator& accumulator, 
+                                      int offset,
+                                      int max_result_count,
+                                      vector<Document>& top_documents) const
+{
+    top_documents.clear();
+    if (max_result_count == 0)
+    {
+        return;
+    }
+    const size_t heap_size = static_cast<size_t>(offset) + static_cast<size_t>(max_result_count);
+    top_documents.reserve(min(heap_size, accumulator.GetTouchedCount()));
+
+    accumulator.ForEach([this, &top_documents, heap_size](int slot, double relevance){
+        PushTopDocument(top_documents, heap_size, {slot_document_ids_[slot], relevance, slot_ratings_[slot]});
+    });
 
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const {
-    return log(GetDocumentCount() * 1.0 / (word_to_document_freqs_.find(word)->second).size());
+    FinishTopDocuments(top_documents, offset);
 }
 
-const map<string, double, std::less<>>& SearchServer::GetWordFrequencies(int document_id) const {
+void SearchServer::PushTopDocument(vector<Document>& heap, size_t heap_size, const Document& document)
+{
+    if (heap.size() < heap_size)
+    {
+        heap.push_back(document);
+        push_heap(heap.begin(), heap.end(), IsMoreRelevant);
+    }
+    else if (IsMoreRelevant(document, heap.front()))
+    {
+        pop_heap(heap.begin(), heap.end(), IsMoreRelevant);
+        heap.back() = document;
+        push_heap(heap.begin(), heap.end(), IsMoreRelevant);
+    }
+}
 
-    if (doc_to_words_freeqs_.count(document_id) > 0)
+void SearchServer::FinishTopDocuments(vector<Document>& heap, int offset)
+{
+    sort_heap(heap.begin(), heap.end(), IsMoreRelevant);
+    heap.erase(heap.begin(), heap.begin() + min(static_cast<size_t>(offset), heap.size()));
+}
+
+void SearchServer::GetDocumentTermIds(int document_id, vector<TermId>& term_ids) const
+{
+    term_ids.clear();
+    const auto slot_it = document_to_slot_.find(document_id);
+    if (slot_it == document_to_slot_.end())
     {
-        return doc_to_words_freeqs_.at(document_id);
+        return;
     }
+    const TermFreqs& term_freqs = slot_term_freqs_[slot_it->second];
+    term_ids.reserve(term_freqs.size());
+    for (const auto& [term_id, _] : term_freqs)
+    {
+        term_ids.push_back(term_id);
+    }
+}
 
-    static map<string, double, std::less<>> empty_map;
-    return empty_map;
+map<string_view, double> SearchServer::GetWordFrequencies(int document_id) const {
+
+    map<string_view, double> words_freqs;
+    const auto slot_it = document_to_slot_.find(document_id);
+    if (slot_it == document_to_slot_.end())
+    {
+        return words_freqs;
+    }
+
+    for (const auto& [term_id, term_freq] : slot_term_freqs_[slot_it->second])
+    {
+        words_freqs.emplace(dictionary_.GetTerm(term_id), term_freq);
+    }
+    return words_freqs;
 }
 
 void SearchServer::RemoveDocument(int document_id)
 {
-    if (doc_ids_.count(document_id) < 1)
+    const auto slot_it = document_to_slot_.find(document_id);
+    if (slot_it == document_to_slot_.end())
     {
         return;
     }
+    const int slot = slot_it->second;
 
-    for (auto& [word, _] : doc_to_words_freeqs_.at(document_id))
+    for (const auto& [term_id, _] : slot_term_freqs_[slot])
     {
-        (word_to_document_freqs_.find(word)->second).erase(document_id);
+        WordPostings& word_postings = term_postings_[term_id];
+        if (--word_postings.document_freq == 0)
+        {
+            word_postings = WordPostings{};
+        }
+        else
+        {
+            word_postings.UpdateDocumentFreq();
+        }
     }
 
-    documents_.erase(document_id);
-    doc_to_words_freeqs_.erase(document_id); 
+    slot_term_freqs_[slot] = TermFreqs{};
+    removed_slots_[slot] = true;
+    ++removed_slot_count_;
+    document_to_slot_.erase(slot_it);
     doc_ids_.erase(document_id);
+    UpdateDocumentCount();
+    PurgeRemovedDocumentsIfNeeded();
 }
 
 
@@ -180,26 +606,460 @@ void SearchServer::RemoveDocument(std::execution::sequenced_policy, int document
 
 void SearchServer::RemoveDocument(std::execution::parallel_policy, int document_id)
 {
-    
-    if (doc_ids_.count(document_id) < 1)
+    // Логическое удаление не перебирает списки вхождений, параллелить нечего
+    return RemoveDocument(document_id);
+}
+
+void SearchServer::RemoveDocuments(const vector<int>& document_ids)
+{
+    RemoveDocumentsImpl(execution::seq, document_ids);
+}
+
+void SearchServer::RemoveDocuments(execution::sequenced_policy, const vector<int>& document_ids)
+{
+    RemoveDocumentsImpl(execution::seq, document_ids);
+}
+
+void SearchServer::RemoveDocuments(execution::parallel_policy, const vector<int>& document_ids)
+{
+    RemoveDocumentsImpl(execution::par, document_ids);
+}
+
+template <typename ExecutionPolicy>
+void SearchServer::RemoveDocumentsImpl(const ExecutionPolicy& policy, const vector<int>& document_ids)
+{
+    // Номера слов удаляемых документов с повторами. Память пропорциональна объёму удаляемых
+    // документов, а не размеру словаря, поэтому удаление одного документа остаётся дешёвым
+    vector<TermId> removed_terms;
+    for (const int document_id : document_ids)
+    {
+        const auto slot_it = document_to_slot_.find(document_id);
+        if (slot_it == document_to_slot_.end())
+        {
+            continue;
+        }
+        const int slot = slot_it->second;
+        for (const auto& [term_id, _] : slot_term_freqs_[slot])
+        {
+            removed_terms.push_back(term_id);
+        }
+
+        slot_term_freqs_[slot] = TermFreqs{};
+        removed_slots_[slot] = true;
+        ++removed_slot_count_;
+        document_to_slot_.erase(slot_it);
+        doc_ids_.erase(document_id);
+    }
+
+    // После сортировки число удаляемых вхождений слова — длина отрезка его повторов
+    sort(policy, removed_terms.begin(), removed_terms.end());
+    vector<pair<TermId, int>> removed_freqs;
+    for (size_t i = 0; i < removed_terms.size();)
+    {
+        size_t run_end = i + 1;
+        while (run_end < removed_terms.size() && removed_terms[run_end] == removed_terms[i])
+        {
+            ++run_end;
+        }
+        removed_freqs.emplace_back(removed_terms[i], static_cast<int>(run_end - i));
+        i = run_end;
+    }
+
+    // Каждое слово обновляется ровно один раз, поэтому слова обрабатываются независимо
+    for_each(policy, removed_freqs.begin(), removed_freqs.end(), [this](const pair<TermId, int>& removed_freq) {
+        WordPostings& word_postings = term_postings_[removed_freq.first];
+        word_postings.document_freq -= removed_freq.second;
+        if (word_postings.document_freq == 0)
+        {
+            word_postings = WordPostings{};
+        }
+        else
+        {
+            word_postings.UpdateDocumentFreq();
+        }
+    });
+
+    UpdateDocumentCount();
+    PurgeRemovedDocumentsIfNeeded();
+}
+
+void SearchServer::PurgeRemovedDocumentsIfNeeded()
+{
+    if (removed_slot_count_ >= MIN_PURGE_SLOT_COUNT && removed_slot_count_ >= doc_ids_.size())
+    {
+        PurgeRemovedDocuments();
+    }
+}
+
+void SearchServer::PurgeRemovedDocuments()
+{
+    if (removed_slot_count_ == 0)
     {
         return;
     }
-    
-    const auto& words_freeqs = doc_to_words_freeqs_.at(document_id);        
-    vector<pair<string, double>> words_freeqs_v(words_freeqs.begin(), words_freeqs.end());
-    
-    for_each(
-        std::execution::par,
-        words_freeqs_v.begin(), words_freeqs_v.end(),
-        [this, document_id](const pair<string, double>& item){ 
-            (word_to_document_freqs_.find(item.first)->second).erase(document_id);
+
+    const size_t slot_count = slot_document_ids_.size();
+    vector<int> new_slots(slot_count, -1);
+    int live_slot_count = 0;
+    for (size_t slot = 0; slot < slot_count; ++slot)
+    {
+        if (!removed_slots_[slot])
+        {
+            new_slots[slot] = live_slot_count++;
         }
-    );
+    }
 
-    documents_.erase(document_id);
-    doc_ids_.erase(document_id);
-    doc_to_words_freeqs_.erase(document_id);
+    // Каждый список перестраивается независимо; порядок живых слотов сохраняется при перенумерации
+    for_each(execution::par, term_postings_.begin(), term_postings_.end(), [&new_slots](WordPostings& word_postings) {
+        if (word_postings.document_freq == 0)
+        {
+            word_postings = WordPostings{};
+            return;
+        }
+        PostingList postings;
+        for (const auto [slot, term_freq] : word_postings.postings)
+        {
+            if (new_slots[slot] >= 0)
+            {
+                postings.Add(new_slots[slot], term_freq);
+            }
+        }
+        word_postings.postings = move(postings);
+    });
+
+    for (size_t slot = 0; slot < slot_count; ++slot)
+    {
+        const int new_slot = new_slots[slot];
+        if (new_slot >= 0 && new_slot != static_cast<int>(slot))
+        {
+            slot_document_ids_[new_slot] = slot_document_ids_[slot];
+            slot_ratings_[new_slot] = slot_ratings_[slot];
+            slot_statuses_[new_slot] = slot_statuses_[slot];
+            slot_term_freqs_[new_slot] = move(slot_term_freqs_[slot]);
+        }
+    }
+    slot_document_ids_.resize(live_slot_count);
+    slot_ratings_.resize(live_slot_count);
+    slot_statuses_.resize(live_slot_count);
+    slot_term_freqs_.resize(live_slot_count);
+    removed_slots_.assign(live_slot_count, false);
+    removed_slot_count_ = 0;
+
+    for (auto& [document_id, slot] : document_to_slot_)
+    {
+        slot = new_slots[slot];
+    }
+
+    CompactTerms();
+}
+
+void SearchServer::CompactTerms()
+{
+    // Слово, добавленное в словарь без списка вхождений, тоже считается выброшенным
+    vector<bool> is_live_term(dictionary_.size(), false);
+    size_t live_term_count = 0;
+    for (TermId term_id = 0; term_id < term_postings_.size(); ++term_id)
+    {
+        if (term_postings_[term_id].document_freq > 0)
+        {
+            is_live_term[term_id] = true;
+            ++live_term_count;
+        }
+    }
+    if (live_term_count == dictionary_.size())
+    {
+        return;
+    }
+
+    // Новые номера возрастают вместе со старыми, поэтому списки сдвигаются на месте,
+    // а частоты слов документа остаются упорядоченными по номеру
+    const vector<TermId> new_term_ids = dictionary_.Compact(is_live_term);
+    for (TermId term_id = 0; term_id < term_postings_.size(); ++term_id)
+    {
+        const TermId new_term_id = new_term_ids[term_id];
+        if (new_term_id != TermDictionary::NO_TERM && new_term_id != term_id)
+        {
+            term_postings_[new_term_id] = move(term_postings_[term_id]);
+        }
+    }
+    term_postings_.resize(live_term_count);
+    term_postings_.shrink_to_fit();
 
+    for_each(execution::par, slot_term_freqs_.begin(), slot_term_freqs_.end(), [&new_term_ids](TermFreqs& term_freqs) {
+        for (auto& [term_id, _] : term_freqs)
+        {
+            term_id = new_term_ids[term_id];
+        }
+    });
 }
 
+void SearchServer::SaveSnapshot(const string& path) const
+{
+    // В снимок попадают только живые документы, поэтому формат не хранит надгробий.
+    // Слоты живых документов перенумеровываются подряд на лету, без копии сервера
+    const bool has_removed_slots = removed_slot_count_ > 0;
+    vector<int> new_slots;
+    if (has_removed_slots)
+    {
+        new_slots.assign(slot_document_ids_.size(), -1);
+        int live_slot_count = 0;
+        for (size_t slot = 0; slot < slot_document_ids_.size(); ++slot)
+        {
+            if (!removed_slots_[slot])
+            {
+                new_slots[slot] = live_slot_count++;
+            }
+        }
+    }
+
+    SnapshotWriter writer(path);
+    writer.WriteValue(SNAPSHOT_MAGIC);
+    writer.WriteValue(SNAPSHOT_VERSION);
+
+    writer.WriteValue<uint64_t>(stop_words_.size());
+    for (string_view word : stop_words_)
+    {
+        writer.WriteString(word);
+    }
+
+    dictionary_.Save(writer);
+    writer.WriteValue<uint64_t>(term_postings_.size());
+    for (const WordPostings& word_postings : term_postings_)
+    {
+        if (!has_removed_slots)
+        {
+            word_postings.postings.Save(writer);
+            continue;
+        }
+        // Список без живых документов сохраняется пустым, как после очистки
+        PostingList postings;
+        if (word_postings.document_freq > 0)
+        {
+            for (const auto [slot, term_freq] : word_postings.postings)
+            {
+                if (new_slots[slot] >= 0)
+                {
+                    postings.Add(new_slots[slot], term_freq);
+                }
+            }
+        }
+        postings.Save(writer);
+    }
+
+    const auto is_live_slot = [this, has_removed_slots](size_t slot) {
+        return !has_removed_slots || !removed_slots_[slot];
+    };
+    const auto write_live_slots = [this, &writer, has_removed_slots](const auto& values) {
+        if (!has_removed_slots)
+        {
+            writer.WriteArray(values);
+            return;
+        }
+        decay_t<decltype(values)> live_values;
+        live_values.reserve(values.size() - removed_slot_count_);
+        for (size_t slot = 0; slot < values.size(); ++slot)
+        {
+            if (!removed_slots_[slot])
+            {
+                live_values.push_back(values[slot]);
+            }
+        }
+        writer.WriteArray(live_values);
+    };
+    write_live_slots(slot_document_ids_);
+    write_live_slots(slot_ratings_);
+    write_live_slots(slot_statuses_);
+
+    // Прямой индекс хранится плоскими массивами: число слов каждого слота, номера слов и частоты
+    vector<uint32_t> slot_term_counts;
+    vector<TermId> term_ids;
+    vector<double> term_freqs;
+    slot_term_counts.reserve(slot_term_freqs_.size() - removed_slot_count_);
+    for (size_t slot = 0; slot < slot_term_freqs_.size(); ++slot)
+    {
+        if (!is_live_slot(slot))
+        {
+            continue;
+        }
+        slot_term_counts.push_back(static_cast<uint32_t>(slot_term_freqs_[slot].size()));
+        for (const auto& [term_id, term_freq] : slot_term_freqs_[slot])
+        {
+            term_ids.push_back(term_id);
+            term_freqs.push_back(term_freq);
+        }
+    }
+    writer.WriteArray(slot_term_counts);
+    writer.WriteArray(term_ids);
+    writer.WriteArray(term_freqs);
+
+    // Слоты удалённых документов не переиспользуются, поэтому сохраняются только живые пары id-слот
+    vector<int> document_ids(doc_ids_.begin(), doc_ids_.end());
+    vector<int> document_slots;
+    document_slots.reserve(document_ids.size());
+    for (int document_id : document_ids)
+    {
+        const int slot = document_to_slot_.at(document_id);
+        document_slots.push_back(has_removed_slots ? new_slots[slot] : slot);
+    }
+    writer.WriteArray(document_ids);
+    writer.WriteArray(document_slots);
+
+    writer.Finish();
+}
+
+SearchServer SearchServer::LoadSnapshot(const string& path)
+{
+    const MappedFile file(path);
+    SnapshotReader reader(file.data(), file.size());
+
+    if (file.size() < sizeof(SNAPSHOT_MAGIC) || reader.ReadValue<uint64_t>() != SNAPSHOT_MAGIC)
+    {
+        throw runtime_error("Файл не является снимком индекса: "s + path);
+    }
+    const uint32_t version = reader.ReadValue<uint32_t>();
+    if (version != SNAPSHOT_VERSION)
+    {
+        throw runtime_error("Неподдерживаемая версия снимка индекса: "s + to_string(version));
+    }
+
+    const uint64_t stop_word_count = reader.ReadValue<uint64_t>();
+    if (stop_word_count > reader.GetRemainingSize() / sizeof(uint64_t))
+    {
+        ThrowCorruptedSnapshot("неверное количество стоп-слов"s);
+    }
+    vector<string_view> stop_words(stop_word_count);
+    for (string_view& word : stop_words)
+    {
+        word = reader.ReadString();
+    }
+    // Конструктор отвергает стоп-слова со спецсимволами; в снимке это означает повреждение
+    SearchServer server = [&stop_words] {
+        try
+        {
+            return SearchServer(stop_words);
+        }
+        catch (const invalid_argument&)
+        {
+            ThrowCorruptedSnapshot("некорректное стоп-слово"s);
+        }
+    }();
+
+    server.dictionary_.Load(reader);
+    if (reader.ReadValue<uint64_t>() != server.dictionary_.size())
+    {
+        ThrowCorruptedSnapshot("число списков вхождений не совпадает с размером словаря"s);
+    }
+    server.term_postings_.resize(server.dictionary_.size());
+    for (WordPostings& word_postings : server.term_postings_)
+    {
+        word_postings.postings.Load(reader);
+        word_postings.document_freq = static_cast<int>(word_postings.postings.size());
+        word_postings.UpdateDocumentFreq();
+    }
+
+    reader.ReadArray(server.slot_document_ids_);
+    reader.ReadArray(server.slot_ratings_);
+    reader.ReadArray(server.slot_statuses_);
+    const size_t slot_count = server.slot_document_ids_.size();
+    if (server.slot_ratings_.size() != slot_count || server.slot_statuses_.size() != slot_count)
+    {
+        ThrowCorruptedSnapshot("массивы данных документов разной длины"s);
+    }
+    if (any_of(server.slot_statuses_.begin(), server.slot_statuses_.end(), [](DocumentStatus status) {
+            return static_cast<int>(status) < static_cast<int>(DocumentStatus::ACTUAL)
+                || static_cast<int>(status) > static_cast<int>(DocumentStatus::REMOVED);
+        }))
+    {
+        ThrowCorruptedSnapshot("неизвестный статус документа"s);
+    }
+    // Поиск обращается к данным слота по id из списков вхождений без проверок
+    for (const WordPostings& word_postings : server.term_postings_)
+    {
+        if (!word_postings.postings.empty()
+            && static_cast<size_t>(word_postings.postings.GetLastDocumentId()) >= slot_count)
+        {
+            ThrowCorruptedSnapshot("слот в списке вхождений вне массива документов"s);
+        }
+    }
+
+    vector<uint32_t> slot_term_counts;
+    vector<TermId> term_ids;
+    vector<double> term_freqs;
+    reader.ReadArray(slot_term_counts);
+    reader.ReadArray(term_ids);
+    reader.ReadArray(term_freqs);
+    if (slot_term_counts.size() != slot_count || term_ids.size() != term_freqs.size()
+        || accumulate(slot_term_counts.begin(), slot_term_counts.end(), uint64_t{0}) != term_ids.size())
+    {
+        ThrowCorruptedSnapshot("неверный размер прямого индекса"s);
+    }
+    if (any_of(term_ids.begin(), term_ids.end(), [&server](TermId term_id) { return term_id >= server.dictionary_.size(); }))
+    {
+        ThrowCorruptedSnapshot("номер слова вне словаря"s);
+    }
+    server.slot_term_freqs_.resize(slot_count);
+    size_t term_pos = 0;
+    for (size_t slot = 0; slot < slot_count; ++slot)
+    {
+        TermFreqs& slot_term_freqs = server.slot_term_freqs_[slot];
+        slot_term_freqs.reserve(slot_term_counts[slot]);
+        for (uint32_t i = 0; i < slot_term_counts[slot]; ++i, ++term_pos)
+        {
+            if (i > 0 && term_ids[term_pos] <= term_ids[term_pos - 1])
+            {
+                ThrowCorruptedSnapshot("слова документа не упорядочены по номеру"s);
+            }
+            slot_term_freqs.emplace_back(term_ids[term_pos], term_freqs[term_pos]);
+        }
+    }
+
+    // Прямой индекс должен описывать те же вхождения, что и списки: по нему уменьшаются частоты при удалении
+    vector<size_t> forward_document_freqs(server.term_postings_.size(), 0);
+    for (const TermId term_id : term_ids)
+    {
+        ++forward_document_freqs[term_id];
+    }
+    for (size_t term_id = 0; term_id < server.term_postings_.size(); ++term_id)
+    {
+        if (forward_document_freqs[term_id] != server.term_postings_[term_id].postings.size())
+        {
+            ThrowCorruptedSnapshot("прямой индекс не совпадает со списками вхождений"s);
+        }
+    }
+
+    vector<int> document_ids;
+    vector<int> document_slots;
+    reader.ReadArray(document_ids);
+    reader.ReadArray(document_slots);
+    if (document_ids.size() != document_slots.size())
+    {
+        ThrowCorruptedSnapshot("неверный список документов"s);
+    }
+    server.document_to_slot_.reserve(document_ids.size());
+    for (size_t i = 0; i < document_ids.size(); ++i)
+    {
+        if (document_ids[i] < 0 || document_slots[i] < 0 || static_cast<size_t>(document_slots[i]) >= slot_count
+            || server.slot_document_ids_[document_slots[i]] != document_ids[i]
+            || !server.document_to_slot_.emplace(document_ids[i], document_slots[i]).second)
+        {
+            ThrowCorruptedSnapshot("неверный список документов"s);
+        }
+        server.doc_ids_.insert(server.doc_ids_.end(), document_ids[i]);
+    }
+
+    if (!reader.AtEnd())
+    {
+        ThrowCorruptedSnapshot("лишние данные в конце файла"s);
+    }
+
+    // Слоты без документа остались от удалений до сохранения; их списки вхождений уже очищены
+    server.removed_slots_.assign(slot_count, true);
+    for (const auto& [document_id, slot] : server.document_to_slot_)
+    {
+        server.removed_slots_[slot] = false;
+    }
+    server.removed_slot_count_ = slot_count - server.document_to_slot_.size();
+
+    server.UpdateDocumentCount();
+    return server;
+}
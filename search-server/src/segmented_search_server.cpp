@@ -0,0 +1,421 @@
+#include <algorithm>
+#include <execution>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "../include/segmented_search_server.h"
+
+using namespace std;
+
+SegmentedSearchServer::SegmentedSearchServer(const string& stop_words_text,
+                                             size_t write_buffer_size,
+                                             size_t merge_factor)
+    : SegmentedSearchServer(SplitIntoWords(stop_words_text), write_buffer_size, merge_factor)
+{
+}
+
+SegmentedSearchServer::~SegmentedSearchServer()
+{
+    {
+        lock_guard guard(writer_mutex_);
+        is_stopping_ = true;
+    }
+    merge_requested_.notify_all();
+    merger_.join();
+}
+
+void SegmentedSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings)
+{
+    {
+        lock_guard guard(writer_mutex_);
+        const shared_ptr<const State> state = LoadState();
+        if (HasLiveSegmentDocument(*state, document_id))
+        {
+            throw invalid_argument("Документ с таким ID уже добавлен"s);
+        }
+
+        WriteBuffer& write_buffer = *state->write_buffer;
+        {
+            unique_lock write_buffer_lock(write_buffer.mutex);
+            write_buffer.index.AddDocument(document_id, document, status, ratings);
+        }
+        if (static_cast<size_t>(write_buffer.index.GetDocumentCount()) < write_buffer_size_)
+        {
+            return;
+        }
+        State next = *state;
+        SealWriteBuffer(next);
+        PublishState(move(next));
+    }
+    merge_requested_.notify_one();
+}
+
+void SegmentedSearchServer::AddDocuments(const vector<DocumentToAdd>& documents)
+{
+    shared_ptr<SearchServer> batch = MakeEmptyIndex();
+    batch->AddDocuments(execution::par, documents);
+    if (batch->GetDocumentCount() == 0)
+    {
+        return;
+    }
+    {
+        lock_guard guard(writer_mutex_);
+        const shared_ptr<const State> state = LoadState();
+        WriteBuffer& write_buffer = *state->write_buffer;
+        for (const DocumentToAdd& document : documents)
+        {
+            if (write_buffer.index.HasDocument(document.id) || HasLiveSegmentDocument(*state, document.id))
+            {
+                throw invalid_argument("Документ с таким ID уже добавлен"s);
+            }
+        }
+
+        State next = *state;
+        if (static_cast<size_t>(batch->GetDocumentCount()) >= write_buffer_size_)
+        {
+            next.segments.push_back(MakeSegment(move(batch)));
+        }
+        else
+        {
+            {
+                unique_lock write_buffer_lock(write_buffer.mutex);
+                write_buffer.index.AppendDocuments(*batch, [](int) { return false; });
+            }
+            if (static_cast<size_t>(write_buffer.index.GetDocumentCount()) < write_buffer_size_)
+            {
+                return;
+            }
+            SealWriteBuffer(next);
+        }
+        PublishState(move(next));
+    }
+    merge_requested_.notify_one();
+}
+
+void SegmentedSearchServer::RemoveDocument(int document_id)
+{
+    RemoveDocuments({document_id});
+}
+
+void SegmentedSearchServer::RemoveDocuments(const vector<int>& document_ids)
+{
+    lock_guard guard(writer_mutex_);
+    const shared_ptr<const State> state = LoadState();
+
+    // Документ буфера записи не может одновременно быть живым в сегменте, поэтому id делятся на две части
+    WriteBuffer& write_buffer = *state->write_buffer;
+    vector<int> write_buffer_ids;
+    vector<int> segment_ids;
+    for (const int document_id : document_ids)
+    {
+        (write_buffer.index.HasDocument(document_id) ? write_buffer_ids : segment_ids).push_back(document_id);
+    }
+    if (!write_buffer_ids.empty())
+    {
+        unique_lock write_buffer_lock(write_buffer.mutex);
+        write_buffer.index.RemoveDocuments(write_buffer_ids);
+    }
+    if (segment_ids.empty())
+    {
+        return;
+    }
+
+    State next = *state;
+    bool is_changed = false;
+    for (Segment& segment : next.segments)
+    {
+        is_changed = AddTombstones(segment, segment_ids) || is_changed;
+    }
+    if (is_changed)
+    {
+        PublishState(move(next));
+    }
+}
+
+vector<Document> SegmentedSearchServer::FindTopDocuments(string_view raw_query, DocumentStatus status) const
+{
+    return FindTopDocuments(raw_query, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    });
+}
+
+vector<Document> SegmentedSearchServer::FindTopDocuments(string_view raw_query) const
+{
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+tuple<vector<string_view>, DocumentStatus> SegmentedSearchServer::MatchDocument(string_view raw_query,
+                                                                                int document_id) const
+{
+    return MatchDocument(execution::seq, raw_query, document_id);
+}
+
+int SegmentedSearchServer::GetDocumentCount() const
+{
+    const shared_ptr<const State> state = LoadState();
+    int document_count = 0;
+    {
+        shared_lock write_buffer_lock(state->write_buffer->mutex);
+        document_count = state->write_buffer->index.GetDocumentCount();
+    }
+    for (const Segment& segment : state->segments)
+    {
+        document_count += segment.index->GetDocumentCount() - static_cast<int>(segment.removed_count);
+    }
+    return document_count;
+}
+
+size_t SegmentedSearchServer::GetSegmentCount() const
+{
+    return LoadState()->segments.size();
+}
+
+void SegmentedSearchServer::Flush()
+{
+    {
+        lock_guard guard(writer_mutex_);
+        State next = *LoadState();
+        if (next.write_buffer->index.GetDocumentCount() == 0)
+        {
+            return;
+        }
+        SealWriteBuffer(next);
+        PublishState(move(next));
+    }
+    merge_requested_.notify_one();
+}
+
+void SegmentedSearchServer::WaitForMerges()
+{
+    unique_lock lock(writer_mutex_);
+    merge_finished_.wait(lock, [this] { return !is_merging_ && !IsMergeNeeded(*LoadState()); });
+}
+
+void SegmentedSearchServer::Compact()
+{
+    {
+        lock_guard merge_guard(merge_mutex_);
+        Flush();
+        const shared_ptr<const State> state = LoadState();
+        const bool has_removed_ids = any_of(state->segments.begin(), state->segments.end(), [](const Segment& segment) {
+            return segment.removed_count > 0;
+        });
+        if (state->segments.size() > 1 || has_removed_ids)
+        {
+            MergeSegments(state->segments);
+        }
+    }
+    merge_finished_.notify_all();
+}
+
+shared_ptr<SearchServer> SegmentedSearchServer::MakeEmptyIndex() const
+{
+    return make_shared<SearchServer>(stop_words_);
+}
+
+bool SegmentedSearchServer::Segment::IsRemoved(int document_id) const
+{
+    return any_of(tombstones.begin(), tombstones.end(), [document_id](const shared_ptr<const TombstoneChunk>& chunk) {
+        return chunk->removed_ids.count(document_id) > 0;
+    });
+}
+
+int SegmentedSearchServer::Segment::CountRemovedWithWord(string_view word) const
+{
+    int count = 0;
+    for (const auto& chunk : tombstones)
+    {
+        const auto count_it = chunk->removed_word_counts.find(word);
+        if (count_it != chunk->removed_word_counts.end())
+        {
+            count += count_it->second;
+        }
+    }
+    return count;
+}
+
+SegmentedSearchServer::Segment SegmentedSearchServer::MakeSegment(shared_ptr<const SearchServer> index)
+{
+    return {move(index), {}, 0};
+}
+
+bool SegmentedSearchServer::HasLiveSegmentDocument(const State& state, int document_id)
+{
+    return any_of(state.segments.begin(), state.segments.end(), [document_id](const Segment& segment) {
+        return segment.index->HasDocument(document_id) && !segment.IsRemoved(document_id);
+    });
+}
+
+bool SegmentedSearchServer::AddTombstones(Segment& segment, const vector<int>& document_ids)
+{
+    auto chunk = make_shared<TombstoneChunk>();
+    for (const int document_id : document_ids)
+    {
+        if (!segment.index->HasDocument(document_id) || segment.IsRemoved(document_id)
+            || !chunk->removed_ids.insert(document_id).second)
+        {
+            continue;
+        }
+        for (const auto& [word, _] : segment.index->GetWordFrequencies(document_id))
+        {
+            ++chunk->removed_word_counts[word];
+        }
+    }
+    if (chunk->removed_ids.empty())
+    {
+        return false;
+    }
+    segment.removed_count += chunk->removed_ids.size();
+
+    // Порция сливается с предыдущей, пока та меньше её удвоенного размера: каждое надгробие
+    // копируется при слиянии только после удвоения своей порции, то есть O(log k) раз
+    vector<shared_ptr<const TombstoneChunk>>& tombstones = segment.tombstones;
+    while (!tombstones.empty() && tombstones.back()->removed_ids.size() < 2 * chunk->removed_ids.size())
+    {
+        const TombstoneChunk& previous = *tombstones.back();
+        chunk->removed_ids.insert(previous.removed_ids.begin(), previous.removed_ids.end());
+        for (const auto& [word, count] : previous.removed_word_counts)
+        {
+            chunk->removed_word_counts[word] += count;
+        }
+        tombstones.pop_back();
+    }
+    tombstones.push_back(move(chunk));
+    return true;
+}
+
+shared_ptr<const SegmentedSearchServer::State> SegmentedSearchServer::LoadState() const
+{
+    return atomic_load(&state_);
+}
+
+void SegmentedSearchServer::PublishState(State state)
+{
+    atomic_store(&state_, shared_ptr<const State>(make_shared<State>(move(state))));
+}
+
+vector<SegmentedSearchServer::Segment> SegmentedSearchServer::SelectSegmentsToMerge(const State& state) const
+{
+    // Сегменты делятся на уровни: уровень растёт каждый раз, когда размер увеличивается в merge_factor_ раз.
+    // Сливаются merge_factor_ сегментов одного уровня, поэтому каждый документ переписывается
+    // логарифмическое число раз, а сегментов остаётся не больше (merge_factor_ - 1) на уровень
+    vector<vector<Segment>> tiers;
+    for (const Segment& segment : state.segments)
+    {
+        size_t tier = 0;
+        for (size_t tier_limit = write_buffer_size_ * merge_factor_;
+             static_cast<size_t>(segment.index->GetDocumentCount()) >= tier_limit;
+             tier_limit *= merge_factor_)
+        {
+            ++tier;
+        }
+        if (tiers.size() <= tier)
+        {
+            tiers.resize(tier + 1);
+        }
+        tiers[tier].push_back(segment);
+        if (tiers[tier].size() == merge_factor_)
+        {
+            return tiers[tier];
+        }
+    }
+    return {};
+}
+
+bool SegmentedSearchServer::IsMergeNeeded(const State& state) const
+{
+    return !SelectSegmentsToMerge(state).empty();
+}
+
+void SegmentedSearchServer::SealWriteBuffer(State& state)
+{
+    // Сегмент разделяет владение буфером, чтобы версии, ещё читающие буфер, не потеряли его мьютекс
+    const shared_ptr<const SearchServer> index(state.write_buffer, &state.write_buffer->index);
+    state.segments.push_back(MakeSegment(index));
+    state.write_buffer = make_shared<WriteBuffer>(stop_words_);
+}
+
+void SegmentedSearchServer::MergeSegments(const vector<Segment>& segments)
+{
+    // Слияние выполняется без блокировки писателей: сегменты неизменяемы,
+    // а надгробия, появившиеся за время слияния, переносятся в новый сегмент при публикации
+    auto merged = MakeEmptyIndex();
+    for (const Segment& segment : segments)
+    {
+        merged->AppendDocuments(*segment.index, [&segment](int document_id) {
+            return segment.IsRemoved(document_id);
+        });
+    }
+
+    lock_guard guard(writer_mutex_);
+    const shared_ptr<const State> state = LoadState();
+    State next;
+    next.write_buffer = state->write_buffer;
+    vector<int> removed_during_merge;
+    for (const Segment& segment : state->segments)
+    {
+        const auto merged_it = find_if(segments.begin(), segments.end(), [&segment](const Segment& merged_segment) {
+            return merged_segment.index == segment.index;
+        });
+        if (merged_it == segments.end())
+        {
+            next.segments.push_back(segment);
+            continue;
+        }
+        for (const auto& chunk : segment.tombstones)
+        {
+            for (const int document_id : chunk->removed_ids)
+            {
+                if (!merged_it->IsRemoved(document_id))
+                {
+                    removed_during_merge.push_back(document_id);
+                }
+            }
+        }
+    }
+    if (merged->GetDocumentCount() > 0)
+    {
+        Segment segment = MakeSegment(move(merged));
+        AddTombstones(segment, removed_during_merge);
+        next.segments.push_back(move(segment));
+    }
+    PublishState(move(next));
+}
+
+void SegmentedSearchServer::MergeLoop()
+{
+    while (true)
+    {
+        {
+            unique_lock lock(writer_mutex_);
+            merge_requested_.wait(lock, [this] { return is_stopping_ || IsMergeNeeded(*LoadState()); });
+            if (is_stopping_)
+            {
+                return;
+            }
+            is_merging_ = true;
+        }
+        {
+            lock_guard merge_guard(merge_mutex_);
+            // Пока поток ждал merge_mutex_, Compact мог уже слить выбранные сегменты
+            const vector<Segment> segments = SelectSegmentsToMerge(*LoadState());
+            if (!segments.empty())
+            {
+                MergeSegments(segments);
+            }
+        }
+        {
+            lock_guard guard(writer_mutex_);
+            is_merging_ = false;
+        }
+        merge_finished_.notify_all();
+    }
+}
@@ -0,0 +1,106 @@
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../include/snapshot_io.h"
+
+using namespace std;
+
+SnapshotWriter::SnapshotWriter(const string& path)
+    : path_(path), temp_path_(path + ".tmp"s), out_(temp_path_, ios::binary | ios::trunc)
+{
+    if (!out_)
+    {
+        throw runtime_error("Не удалось открыть файл снимка для записи: "s + temp_path_);
+    }
+}
+
+void SnapshotWriter::WriteString(string_view text)
+{
+    WriteValue<uint64_t>(text.size());
+    WriteBytes(text.data(), text.size());
+}
+
+void SnapshotWriter::Finish()
+{
+    out_.close();
+    if (!out_)
+    {
+        throw runtime_error("Ошибка записи снимка: "s + temp_path_);
+    }
+    if (rename(temp_path_.c_str(), path_.c_str()) != 0)
+    {
+        throw runtime_error("Не удалось заменить файл снимка: "s + path_);
+    }
+}
+
+void SnapshotWriter::WriteBytes(const void* data, size_t size)
+{
+    out_.write(static_cast<const char*>(data), static_cast<streamsize>(size));
+}
+
+MappedFile::MappedFile(const string& path)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw runtime_error("Не удалось открыть файл: "s + path);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0)
+    {
+        close(fd);
+        throw runtime_error("Не удалось определить размер файла: "s + path);
+    }
+
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0)
+    {
+        void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            close(fd);
+            throw runtime_error("Не удалось отобразить файл в память: "s + path);
+        }
+        // Файл читается целиком и по порядку
+        madvise(mapped, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(mapped);
+    }
+    // Отображение остаётся валидным и после закрытия дескриптора
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_ != nullptr)
+    {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+SnapshotReader::SnapshotReader(const char* data, size_t size) : pos_(data), end_(data + size)
+{
+}
+
+string_view SnapshotReader::ReadString()
+{
+    const uint64_t size = ReadValue<uint64_t>();
+    return {ReadBytes(size, 1), static_cast<size_t>(size)};
+}
+
+const char* SnapshotReader::ReadBytes(uint64_t count, size_t element_size)
+{
+    const uint64_t available = static_cast<uint64_t>(end_ - pos_);
+    if (count > available / element_size)
+    {
+        throw runtime_error("Снимок индекса повреждён: неожиданный конец данных"s);
+    }
+    const char* result = pos_;
+    pos_ += count * element_size;
+    return result;
+}
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "../include/stop_word_filter.h"
+
+using namespace std;
+
+StopWordFilter::StopWordFilter(const vector<string_view>& words)
+{
+    for (string_view word : words)
+    {
+        if (!word.empty())
+        {
+            words_.push_back(word);
+        }
+    }
+
+    // Порядок (длина, ключ, слово) делает группы одной длины непрерывными и упорядоченными по ключу
+    sort(words_.begin(), words_.end(), [](string_view lhs, string_view rhs) {
+        return make_tuple(lhs.size(), MakeKey(lhs), lhs) < make_tuple(rhs.size(), MakeKey(rhs), rhs);
+    });
+    words_.erase(unique(words_.begin(), words_.end()), words_.end());
+
+    if (words_.empty())
+    {
+        return;
+    }
+
+    buckets_.resize(words_.back().size() + 1);
+    keys_.reserve(words_.size());
+    for (uint32_t i = 0; i < words_.size(); ++i)
+    {
+        LengthBucket& bucket = buckets_[words_[i].size()];
+        if (bucket.begin == bucket.end)
+        {
+            bucket.begin = i;
+        }
+        bucket.end = i + 1;
+        keys_.push_back(MakeKey(words_[i]));
+    }
+}
+
+bool StopWordFilter::Contains(string_view word) const
+{
+    if (word.size() >= buckets_.size())
+    {
+        return false;
+    }
+    const LengthBucket bucket = buckets_[word.size()];
+    if (bucket.begin == bucket.end)
+    {
+        return false;
+    }
+
+    const uint64_t key = MakeKey(word);
+    const auto keys_end = keys_.begin() + bucket.end;
+    for (auto it = lower_bound(keys_.begin() + bucket.begin, keys_end, key); it != keys_end && *it == key; ++it)
+    {
+        // Ключ совпадает со словом целиком, если слово не длиннее ключа
+        if (word.size() <= KEY_SIZE || words_[it - keys_.begin()] == word)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t StopWordFilter::MakeKey(string_view word)
+{
+    uint64_t key = 0;
+    memcpy(&key, word.data(), min(word.size(), KEY_SIZE));
+    return key;
+}
@@ -0,0 +1,41 @@
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include "../include/string_arena.h"
+
+using namespace std;
+
+StringArena::StringArena(size_t block_size) : block_size_(block_size)
+{
+}
+
+string_view StringArena::Store(string_view text)
+{
+    if (text.empty())
+    {
+        return {};
+    }
+
+    lock_guard guard(mutex_);
+
+    // Длинная строка получает собственный блок, чтобы не тратить остаток текущего
+    if (text.size() > block_size_ / 4)
+    {
+        blocks_.push_back(make_unique<char[]>(text.size()));
+        memcpy(blocks_.back().get(), text.data(), text.size());
+        return {blocks_.back().get(), text.size()};
+    }
+
+    if (text.size() > current_free_)
+    {
+        blocks_.push_back(make_unique<char[]>(block_size_));
+        current_ = blocks_.back().get();
+        current_free_ = block_size_;
+    }
+
+    char* result = current_;
+    memcpy(result, text.data(), text.size());
+    current_ += text.size();
+    current_free_ -= text.size();
+    return {result, text.size()};
+}
@@ -1,35 +1,169 @@
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <string_view>
 #include "../include/string_processing.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SEARCH_SERVER_X86_TOKENIZER
+#endif
+
 using namespace std;
 
-vector<string_view> SplitIntoWords(string_view text) {
-    vector<string_view> words;
-    int last = -1;
-    for (int i = 0; i < text.size(); ++i) {
-        
-        char c = text[i];
-        if (c != ' ' && last == -1)
+namespace {
+
+// Состояние разбора, переходящее между блоками текста
+struct SplitState {
+    size_t word_start = 0;
+    bool in_word = false;
+    bool has_control = false;
+};
+
+// Побайтовый разбор участка [pos, end). Используется для хвоста, не заполняющего блок,
+// и как самостоятельная реализация на процессорах без векторных инструкций
+void SplitScalar(string_view text, size_t pos, SplitState& state, vector<string_view>& words)
+{
+    for (; pos < text.size(); ++pos)
+    {
+        const unsigned char c = static_cast<unsigned char>(text[pos]);
+        state.has_control |= c < ' ';
+        if ((c != ' ') != state.in_word)
         {
-            last = i;
-            continue;
+            if (state.in_word)
+            {
+                words.emplace_back(text.data() + state.word_start, pos - state.word_start);
+            }
+            else
+            {
+                state.word_start = pos;
+            }
+            state.in_word = !state.in_word;
         }
-        if (c == ' ' && last != -1)
+    }
+}
+
+// Разбор блоками по BLOCK_SIZE байт. compute_masks возвращает битовые маски пробелов
+// и управляющих символов блока; границы слов находятся как смены бита «не пробел».
+template <size_t BLOCK_SIZE, typename ComputeMasks>
+bool SplitBlocks(string_view text, vector<string_view>& words, ComputeMasks compute_masks)
+{
+    constexpr uint32_t BLOCK_MASK = BLOCK_SIZE == 32 ? ~uint32_t{0} : (uint32_t{1} << BLOCK_SIZE) - 1;
+
+    SplitState state;
+    uint32_t control_bits = 0;
+    size_t pos = 0;
+    for (; pos + BLOCK_SIZE <= text.size(); pos += BLOCK_SIZE)
+    {
+        const auto [space_bits, block_control_bits] = compute_masks(text.data() + pos);
+        control_bits |= block_control_bits;
+
+        const uint32_t word_bits = ~space_bits & BLOCK_MASK;
+        uint32_t boundary_bits = (word_bits ^ ((word_bits << 1) | uint32_t{state.in_word})) & BLOCK_MASK;
+        while (boundary_bits != 0)
         {
-            std::string_view word(text.data() + last, i - last);
-            words.push_back(word);
-            last = -1;
+            const size_t boundary = pos + static_cast<size_t>(__builtin_ctz(boundary_bits));
+            if (state.in_word)
+            {
+                words.emplace_back(text.data() + state.word_start, boundary - state.word_start);
+            }
+            else
+            {
+                state.word_start = boundary;
+            }
+            state.in_word = !state.in_word;
+            boundary_bits &= boundary_bits - 1;
         }
-        
     }
-    if (last != -1)
+
+    state.has_control = control_bits != 0;
+    SplitScalar(text, pos, state, words);
+    if (state.in_word)
+    {
+        words.emplace_back(text.data() + state.word_start, text.size() - state.word_start);
+    }
+    return !state.has_control;
+}
+
+bool SplitIntoWordsScalar(string_view text, vector<string_view>& words)
+{
+    SplitState state;
+    SplitScalar(text, 0, state, words);
+    if (state.in_word)
+    {
+        words.emplace_back(text.data() + state.word_start, text.size() - state.word_start);
+    }
+    return !state.has_control;
+}
+
+#ifdef SEARCH_SERVER_X86_TOKENIZER
+
+struct BlockMasks {
+    uint32_t space_bits;
+    uint32_t control_bits;
+};
+
+// Управляющий символ — байт не больше 0x1F: min(c, 0x1F) == c при беззнаковом сравнении.
+// flatten встраивает цикл по блокам вместе с вычислением масок в функцию с нужным набором инструкций
+__attribute__((target("sse2"), flatten))
+bool SplitIntoWordsSse2(string_view text, vector<string_view>& words)
+{
+    return SplitBlocks<16>(text, words, [](const char* block) __attribute__((target("sse2"))) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+        const __m128i spaces = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+        const __m128i controls = _mm_cmpeq_epi8(_mm_min_epu8(bytes, _mm_set1_epi8(0x1F)), bytes);
+        return BlockMasks{static_cast<uint32_t>(_mm_movemask_epi8(spaces)),
+                          static_cast<uint32_t>(_mm_movemask_epi8(controls))};
+    });
+}
+
+__attribute__((target("avx2"), flatten))
+bool SplitIntoWordsAvx2(string_view text, vector<string_view>& words)
+{
+    return SplitBlocks<32>(text, words, [](const char* block) __attribute__((target("avx2"))) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        const __m256i spaces = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '));
+        const __m256i controls = _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, _mm256_set1_epi8(0x1F)), bytes);
+        return BlockMasks{static_cast<uint32_t>(_mm256_movemask_epi8(spaces)),
+                          static_cast<uint32_t>(_mm256_movemask_epi8(controls))};
+    });
+}
+
+#endif
+
+using SplitImplementation = bool (*)(string_view, vector<string_view>&);
+
+// Реализация выбирается один раз по возможностям процессора
+SplitImplementation SelectSplitImplementation()
+{
+#ifdef SEARCH_SERVER_X86_TOKENIZER
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SplitIntoWordsAvx2;
+    }
+    if (__builtin_cpu_supports("sse2"))
     {
-        std::string_view word(text.data() + last, text.size() - last);
-        words.push_back(word);
+        return SplitIntoWordsSse2;
     }
-    
+#endif
+    return SplitIntoWordsScalar;
+}
+
+}
+
+vector<string_view> SplitIntoWords(string_view text) {
+    vector<string_view> words;
+    SplitIntoWords(text, words);
     return words;
 }
 
+void SplitIntoWords(string_view text, vector<string_view>& words) {
+    SplitIntoWordsAndValidate(text, words);
+}
+
+bool SplitIntoWordsAndValidate(string_view text, vector<string_view>& words) {
+    static const SplitImplementation split_implementation = SelectSplitImplementation();
+    return split_implementation(text, words);
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "../include/term_dictionary.h"
+
+using namespace std;
+
+namespace {
+
+constexpr size_t INITIAL_TABLE_SIZE = 16;
+
+}
+
+TermDictionary::TermDictionary() : TermDictionary(make_shared<StringArena>())
+{
+}
+
+TermDictionary::TermDictionary(shared_ptr<StringArena> arena)
+    : arena_(move(arena)), table_(INITIAL_TABLE_SIZE, NO_TERM)
+{
+}
+
+TermId TermDictionary::Find(string_view word) const
+{
+    return table_[FindPosition(word)];
+}
+
+TermId TermDictionary::Insert(string_view word)
+{
+    size_t position = FindPosition(word);
+    if (table_[position] != NO_TERM)
+    {
+        return table_[position];
+    }
+
+    // Заполненность таблицы не превышает половины
+    if ((terms_.size() + 1) * 2 > table_.size())
+    {
+        Grow();
+        position = FindPosition(word);
+    }
+
+    const TermId term_id = static_cast<TermId>(terms_.size());
+    terms_.push_back(arena_->Store(word));
+    table_[position] = term_id;
+    return term_id;
+}
+
+vector<TermId> TermDictionary::Compact(const vector<bool>& is_live)
+{
+    TermDictionary compacted;
+    compacted.Reserve(count(is_live.begin(), is_live.end(), true));
+    vector<TermId> new_term_ids(terms_.size(), NO_TERM);
+    for (TermId term_id = 0; term_id < terms_.size(); ++term_id)
+    {
+        if (is_live[term_id])
+        {
+            new_term_ids[term_id] = compacted.Insert(terms_[term_id]);
+        }
+    }
+    *this = move(compacted);
+    return new_term_ids;
+}
+
+size_t TermDictionary::FindPosition(string_view word) const
+{
+    const size_t mask = table_.size() - 1;
+    size_t position = hash<string_view>{}(word) & mask;
+    while (table_[position] != NO_TERM && terms_[table_[position]] != word)
+    {
+        position = (position + 1) & mask;
+    }
+    return position;
+}
+
+void TermDictionary::Reserve(size_t term_count)
+{
+    size_t table_size = INITIAL_TABLE_SIZE;
+    while (table_size < term_count * 2)
+    {
+        table_size *= 2;
+    }
+    table_.assign(table_size, NO_TERM);
+    terms_.reserve(term_count);
+}
+
+void TermDictionary::Grow()
+{
+    table_.assign(table_.size() * 2, NO_TERM);
+    const size_t mask = table_.size() - 1;
+    for (TermId term_id = 0; term_id < terms_.size(); ++term_id)
+    {
+        size_t position = hash<string_view>{}(terms_[term_id]) & mask;
+        while (table_[position] != NO_TERM)
+        {
+            position = (position + 1) & mask;
+        }
+        table_[position] = term_id;
+    }
+}
+
+void TermDictionary::Save(SnapshotWriter& writer) const
+{
+    writer.WriteValue<uint64_t>(terms_.size());
+    for (string_view term : terms_)
+    {
+        writer.WriteString(term);
+    }
+}
+
+void TermDictionary::Load(SnapshotReader& reader)
+{
+    const uint64_t term_count = reader.ReadValue<uint64_t>();
+
+    // Перед каждым словом в снимке записана его длина
+    if (!terms_.empty() || term_count > reader.GetRemainingSize() / sizeof(uint64_t))
+    {
+        throw runtime_error("Снимок индекса повреждён: неверное количество слов словаря"s);
+    }
+
+    Reserve(term_count);
+    for (uint64_t i = 0; i < term_count; ++i)
+    {
+        if (Insert(reader.ReadString()) != i)
+        {
+            throw runtime_error("Снимок индекса повреждён: слово словаря повторяется"s);
+        }
+    }
+}
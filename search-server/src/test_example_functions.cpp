@@ -9,6 +9,28 @@
 #include "../include/request_queue.h"
 #include "../include/remove_duplicates.h"
 #include "../include/paginator.h"
+#include "../include/posting_list.h"
+#include "../include/score_accumulator.h"
+#include "../include/benchmarks.h"
+#include "../include/term_dictionary.h"
+#include "../include/corpus_ingestion.h"
+#include "../include/small_vector.h"
+#include "../include/stop_word_filter.h"
+#include "../include/query_executor.h"
+#include "../include/process_queries.h"
+#include "../include/concurrent_search_server.h"
+#include "../include/segmented_search_server.h"
+#include <execution>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <map>
+#include <set>
+#include <memory>
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+#include <unistd.h>
 
 using namespace std;
 
@@ -29,6 +51,17 @@ void AssertImpl(bool value,
     }
 }
 
+void AssertSameDocuments(const vector<Document>& actual, const vector<Document>& expected)
+{
+    ASSERT_EQUAL(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i)
+    {
+        ASSERT_EQUAL(actual[i].id, expected[i].id);
+        ASSERT_EQUAL(actual[i].rating, expected[i].rating);
+        ASSERT(abs(actual[i].relevance - expected[i].relevance) < RELEVANCE_ERROR);
+    }
+}
+
 // -------- Начало модульных тестов поисковой системы ----------
 
 // Тест проверяет, что поисковая система исключает стоп-слова при добавлении документов
@@ -422,6 +455,15 @@ void TestRemoveDocument()
     
     ASSERT_EQUAL_HINT(server.GetDocumentCount(), 1, "Количество документов после удаления не соответсвует."s);
     ASSERT_HINT(count(server.begin(), server.end(), 1) > 0, "После удаления документа был удалён другой"s);
+    ASSERT_HINT(server.FindTopDocuments("little dog"s).empty(), "Удалённый документ не должен находиться поиском"s);
+
+    // Повторно добавленный документ с тем же id находится по новому содержимому
+    server.AddDocument(2, "dog with collar"s, DocumentStatus::BANNED, {5});
+    const auto top_docs = server.FindTopDocuments("dog"s, DocumentStatus::BANNED);
+    ASSERT_EQUAL(top_docs.size(), 1u);
+    ASSERT_EQUAL(top_docs[0].id, 2);
+    ASSERT_EQUAL(top_docs[0].rating, 5);
+    ASSERT_HINT(server.FindTopDocuments("little"s).empty(), "Старое содержимое документа не должно находиться поиском"s);
 }
 
 // Тестирование функции удаления дубликатов
@@ -456,70 +498,1836 @@ void TestRemoveDuplicates()
     search_server.AddDocument(9, "nasty rat with curly hair"s, status, rating);
     
     set<int> duplicates {3, 4, 5, 7};
+    ASSERT(FindDuplicates(search_server) == vector<int>(duplicates.begin(), duplicates.end()));
     RemoveDuplicates(search_server);
 
     for (auto it = search_server.begin(); it != search_server.end(); ++it)
     {
         ASSERT_HINT(duplicates.count(*it) < 1, "Дублирующийся документ c id " + to_string(*it) + " не был удалён"s);            
     }
+    ASSERT_HINT(vector<int>(search_server.begin(), search_server.end()) == vector<int>({1, 2, 6, 8, 9}),
+                "Документы, не являющиеся дубликатами, должны остаться"s);
+
+    // На большом корпусе отпечатки находят те же дубликаты, что и прямое сравнение множеств слов
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 50, 5);
+    SearchServer corpus_server(dictionary[0]);
+    map<set<string>, int> first_ids;
+    vector<int> expected;
+    for (int id = 0; id < 5000; ++id)
+    {
+        const string text = GenerateQuery(generator, dictionary, 3, 0.0);
+        corpus_server.AddDocument(id, text, status, rating);
+        const auto words = SplitIntoWords(text);
+        set<string> word_set;
+        for (const string_view word : words)
+        {
+            if (word != dictionary[0])
+            {
+                word_set.emplace(word);
+            }
+        }
+        if (!first_ids.emplace(word_set, id).second)
+        {
+            expected.push_back(id);
+        }
+    }
+    ASSERT(!expected.empty());
+    ASSERT(FindDuplicates(corpus_server) == expected);
+    RemoveDuplicates(corpus_server);
+    ASSERT_EQUAL(corpus_server.GetDocumentCount(), static_cast<int>(first_ids.size()));
+    ASSERT(FindDuplicates(corpus_server).empty());
 }
 
+// Тестирование поиска почти дубликатов
+void TestRemoveNearDuplicates()
+{
+    const auto make_text = [](const vector<int>& word_numbers) {
+        string text;
+        for (const int word_number : word_numbers)
+        {
+            text += "w"s + to_string(word_number) + " "s;
+        }
+        return text;
+    };
 
-// Функция TestSearchServer является точкой входа для запуска тестов
-void TestSearchServer() {
-    RUN_TEST(TestAddDocument);
-    RUN_TEST(TestExcludeStopWordsFromAddedDocumentContent);
-    RUN_TEST(TestMinusWords);
-    RUN_TEST(TestMatchDocument);
-    RUN_TEST(TestSortingByRelevance);
-    RUN_TEST(TestStatusPredicate);
-    RUN_TEST(TestAverageRating);
-    RUN_TEST(TestAnyPredicates);
-    RUN_TEST(TestRemoveDocument);
-    RUN_TEST(TestRemoveDuplicates);
+    SearchServer search_server("and with"s);
+    const DocumentStatus status = DocumentStatus::ACTUAL;
+    const vector<int> rating{1};
+    vector<int> base(10);
+    iota(base.begin(), base.end(), 0);
+    search_server.AddDocument(1, make_text(base), status, rating);
+
+    // Одно слово из десяти заменено: сходство 9/11
+    vector<int> near = base;
+    near[0] = 100;
+    search_server.AddDocument(2, make_text(near), status, rating);
+
+    // Три слова заменены: сходство 7/13
+    vector<int> far = base;
+    far[0] = 200;
+    far[1] = 201;
+    far[2] = 202;
+    search_server.AddDocument(3, make_text(far), status, rating);
+
+    // Другой порядок и повторы слов не влияют на сходство
+    vector<int> shuffled(base.rbegin(), base.rend());
+    shuffled.push_back(5);
+    search_server.AddDocument(4, make_text(shuffled) + "and with"s, status, rating);
+
+    ASSERT(FindNearDuplicates(search_server) == vector<int>({2, 4}));
+    ASSERT(FindNearDuplicates(search_server, 0.5) == vector<int>({2, 3, 4}));
+    ASSERT(FindNearDuplicates(search_server, 1.0) == FindDuplicates(search_server));
+
+    // Тысячи копий в нескольких блоках проверки сравниваются с оставленным документом, а не друг с другом.
+    // Документ, похожий только на почти дубликат, а не на оставленный документ, остаётся
+    {
+        SearchServer copies_server(""s);
+        vector<int> expected;
+        copies_server.AddDocument(0, make_text(base), status, rating);
+        for (int id = 1; id < 10000; ++id)
+        {
+            copies_server.AddDocument(id, make_text(id % 3 == 0 ? base : near), status, rating);
+            expected.push_back(id);
+        }
+        vector<int> chained = near;
+        chained[1] = 101;
+        copies_server.AddDocument(10000, make_text(chained), status, rating);
+        ASSERT(FindNearDuplicates(copies_server) == expected);
+    }
+
+    // Почти копии случайных документов находятся среди несвязанных документов
+    mt19937 generator;
+    uniform_int_distribution<int> word_distribution(0, 9999);
+    SearchServer corpus_server(""s);
+    vector<int> expected;
+    for (int id = 0; id < 2000; id += 2)
+    {
+        set<int> word_numbers;
+        while (word_numbers.size() < 20)
+        {
+            word_numbers.insert(word_distribution(generator));
+        }
+        vector<int> words(word_numbers.begin(), word_numbers.end());
+        corpus_server.AddDocument(id, make_text(words), status, rating);
+        if (id % 4 == 0)
+        {
+            words[id % 20] = 10000 + id;
+            corpus_server.AddDocument(id + 1, make_text(words), status, rating);
+            expected.push_back(id + 1);
+        }
+    }
+    ASSERT(FindNearDuplicates(corpus_server) == expected);
+    RemoveNearDuplicates(corpus_server);
+    ASSERT_EQUAL(corpus_server.GetDocumentCount(), 1000);
 }
 
-// --------- Окончание модульных тестов поисковой системы -----------
+// Тестирование упакованного списка вхождений слова
+void TestPostingList()
+{
+    const auto to_vector = [](const PostingList& postings){
+        return vector<pair<int, double>>(postings.begin(), postings.end());
+    };
 
+    PostingList postings;
+    ASSERT_HINT(postings.empty() && postings.begin() == postings.end(), "Новый список вхождений должен быть пустым"s);
 
-// --------- Начало модульных тестов постраничной выдачи ------------
+    // Большие разности занимают несколько байт varint
+    postings.Add(0, 1.0);
+    postings.Add(5, 0.5);
+    postings.Add(300, 0.125);
+    postings.Add(100000, 0.25);
 
-// Функция проверяет правильность размера страницы при постраничном поиске
-void TestPageSize()
+    const vector<pair<int, double>> expected = {{0, 1.0}, {5, 0.5}, {300, 0.125}, {100000, 0.25}};
+    ASSERT_HINT(to_vector(postings) == expected, "Список вхождений должен быть отсортирован по id документа"s);
+    ASSERT_EQUAL(postings.size(), 4u);
+    ASSERT_EQUAL(postings.GetLastDocumentId(), 100000);
+    ASSERT_EQUAL(postings.GetMaxTermFreq(), 1.0);
+
+    // Переход по точкам входа через несколько блоков
+    PostingList long_postings;
+    for (int id = 0; id < 1000; ++id)
+    {
+        long_postings.Add(id * 3, 0.5);
+    }
+    ASSERT_EQUAL(long_postings.Seek(long_postings.begin(), 601).GetDocumentId(), 603);
+    ASSERT_EQUAL(long_postings.Seek(long_postings.begin(), 2997).GetDocumentId(), 2997);
+    ASSERT_HINT(long_postings.Seek(long_postings.begin(), 3000) == long_postings.end(),
+                "Поиск за последним id должен возвращать конец списка"s);
+}
+
+// Тестирование накопителя релевантности и параллельного поиска на его основе
+void TestScoreAccumulator()
 {
+    const auto to_map = [](const ScoreAccumulator& accumulator){
+        map<int, double> result;
+        accumulator.ForEach([&result](int slot, double score){
+            result[slot] = score;
+        });
+        return result;
+    };
+
+    ScoreAccumulator first(5);
+    first.Add(1, 0.5);
+    first.Add(3, 1.0);
+    first.Add(1, 0.25);
+
+    ScoreAccumulator second(5);
+    second.Add(1, 1.0);
+    second.Add(4, 2.0);
+
+    first.Merge(second);
+    first.Exclude(4);
+    first.Exclude(0);
+    ASSERT_HINT((to_map(first) == map<int, double>{{1, 1.75}, {3, 1.0}}),
+                "Накопители должны суммироваться, исключённые документы пропускаться"s);
+
+    first.Reset(6);
+    ASSERT_HINT(to_map(first).empty(), "После сброса накопитель должен быть пустым"s);
+    first.Add(5, 1.0);
+    ASSERT_HINT((to_map(first) == map<int, double>{{5, 1.0}}), "После сброса очки считаются заново"s);
+
+    // Сброс на меньшее число слотов не сжимает накопитель: хвост остаётся обнулённым
+    first.Reset(2);
+    first.Add(1, 2.0);
+    first.Reset(6);
+    ASSERT_HINT(to_map(first).empty(), "Слоты, затронутые до сброса на меньший размер, должны очищаться"s);
+    first.Add(5, 0.5);
+    ASSERT_HINT((to_map(first) == map<int, double>{{5, 0.5}}), "Хвост накопителя должен оставаться обнулённым"s);
+
+    // Последовательный и параллельный поиск дают одинаковую релевантность
     {
-        SearchServer search_server("and with"s);
-        search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
-        search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2, 3});
-        search_server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::ACTUAL, {1, 2, 8});
-        search_server.AddDocument(4, "big dog cat Vladislav"s, DocumentStatus::ACTUAL, {1, 3, 2});
-        search_server.AddDocument(5, "big dog hamster Borya"s, DocumentStatus::ACTUAL, {1, 1, 1});
-        
-        const auto search_results = search_server.FindTopDocuments("curly dog"s);
-        int page_size = 2;
-        
-        const auto pages = Paginate(search_results, page_size);
-        ASSERT_EQUAL_HINT(pages.size(), 
-                            static_cast<int>(ceil(search_results.size() * 1.0 / page_size)),
-                            "Количество страниц постраничного поиска некорректно"s);
-        
-        for (auto page = pages.begin(); page != pages.end(); ++page) {
-            if (page + 1 != pages.end())
+        SearchServer server("and with"s);
+        server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+        server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2, 3});
+        server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::ACTUAL, {1, 2, 8});
+        server.AddDocument(4, "big dog cat Vladislav"s, DocumentStatus::ACTUAL, {1, 3, 2});
+        server.AddDocument(5, "big dog hamster Borya"s, DocumentStatus::ACTUAL, {1, 1, 1});
+
+        const string query = "curly nasty cat dog hair pet -Borya"s;
+        const auto seq_docs = server.FindTopDocuments(std::execution::seq, query);
+        const auto par_docs = server.FindTopDocuments(std::execution::par, query);
+        ASSERT_EQUAL(seq_docs.size(), par_docs.size());
+        for (size_t i = 0; i < seq_docs.size(); ++i)
+        {
+            ASSERT_EQUAL(seq_docs[i].id, par_docs[i].id);
+            ASSERT_HINT(abs(seq_docs[i].relevance - par_docs[i].relevance) < RELEVANCE_ERROR,
+                        "Релевантность параллельного поиска отличается от последовательного"s);
+        }
+    }
+}
+
+// Тестирование ограничения количества документов в выдаче
+void TestMaxResultCount()
+{
+    SearchServer server(""s);
+    const vector<string> contents = {
+        "cat"s, "cat dog"s, "cat dog bird"s, "cat dog bird fish"s,
+        "cat dog bird fish frog"s, "cat dog bird fish frog mouse"s, "cat cat dog"s, "dog"s
+    };
+    for (size_t i = 0; i < contents.size(); ++i)
+    {
+        server.AddDocument(static_cast<int>(i), contents[i], DocumentStatus::ACTUAL, {static_cast<int>(i)});
+    }
+
+    const auto any_document = [](int, DocumentStatus, int){ return true; };
+    const auto all_docs = server.FindTopDocuments(std::execution::seq, "cat mouse"s, any_document, 100);
+    ASSERT_EQUAL(all_docs.size(), 7u);
+
+    // Выдача по умолчанию ограничена MAX_RESULT_DOCUMENT_COUNT
+    ASSERT_EQUAL(server.FindTopDocuments("cat mouse"s).size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+
+    // Ограниченная выдача совпадает с началом полной
+    for (int count : {0, 1, 3, 7})
+    {
+        const auto top_docs = server.FindTopDocuments(std::execution::par, "cat mouse"s, any_document, count);
+        ASSERT_EQUAL(top_docs.size(), static_cast<size_t>(count));
+        for (int i = 0; i < count; ++i)
+        {
+            ASSERT_EQUAL_HINT(top_docs[i].id, all_docs[i].id, "Отобранные документы должны совпадать с началом полной выдачи"s);
+        }
+    }
+
+    try
+    {
+        server.FindTopDocuments(std::execution::seq, "cat"s, any_document, -1);
+        ASSERT_HINT(false, "Отрицательное количество документов должно приводить к исключению"s);
+    }
+    catch (const invalid_argument&)
+    {
+    }
+}
+
+// Тестирование совпадения выдачи MaxScore с полным подсчётом релевантности
+void TestMaxScorePolicy()
+{
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 60, 6);
+    const auto documents = GenerateQueries(generator, dictionary, 400, 30);
+
+    SearchServer server(dictionary[0]);
+    for (size_t i = 0; i < documents.size(); ++i)
+    {
+        server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {static_cast<int>(i)});
+    }
+    // Удаления оставляют завышенные верхние оценки частот, отсечение должно оставаться точным
+    for (int id = 0; id < 400; id += 7)
+    {
+        server.RemoveDocument(id);
+    }
+
+    const auto even_id = [](int document_id, DocumentStatus, int){ return document_id % 2 == 0; };
+    for (int i = 0; i < 20; ++i)
+    {
+        const string query = GenerateQuery(generator, dictionary, 2 + i % 6, 0.2);
+        for (int count : {1, 5, 20})
+        {
+            const auto expected = server.FindTopDocuments(std::execution::seq, query, even_id, 3, count);
+            const auto actual = server.FindTopDocuments(search_policy::max_score, query, even_id, 3, count);
+            ASSERT_EQUAL_HINT(actual.size(), expected.size(), "Количество документов MaxScore отличается: "s + query);
+            for (size_t j = 0; j < expected.size(); ++j)
             {
-                ASSERT_EQUAL_HINT(page->size(), page_size, "Количество документов на странице некорректно"s); 
+                ASSERT_EQUAL_HINT(actual[j].id, expected[j].id, "Выдача MaxScore отличается: "s + query);
+                ASSERT_HINT(abs(actual[j].relevance - expected[j].relevance) < RELEVANCE_ERROR,
+                            "Релевантность MaxScore отличается: "s + query);
             }
-            else {
-                ASSERT_EQUAL_HINT(page->size(), 
-                                    search_results.size() % page_size, 
-                                    "Количество документов последней страницы некорректно"s); 
+        }
+    }
+
+    // Исключение предиката прерывает разбор окна; следующий запрос с тем же контекстом пула
+    // не должен получить оценки, оставшиеся в окне
+    const string query = dictionary[1] + " "s + dictionary[2] + " "s + dictionary[3];
+    bool is_thrown = false;
+    try
+    {
+        server.FindTopDocuments(search_policy::max_score, query, [](int, DocumentStatus, int) -> bool {
+            throw out_of_range("predicate"s);
+        });
+    }
+    catch (const out_of_range&)
+    {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    const auto expected = server.FindTopDocuments(std::execution::seq, query, even_id, 0, 20);
+    const auto actual = server.FindTopDocuments(search_policy::max_score, query, even_id, 0, 20);
+    ASSERT_EQUAL(actual.size(), expected.size());
+    for (size_t j = 0; j < expected.size(); ++j)
+    {
+        ASSERT_EQUAL(actual[j].id, expected[j].id);
+        ASSERT_HINT(abs(actual[j].relevance - expected[j].relevance) < RELEVANCE_ERROR,
+                    "Оценки прерванного запроса не должны попадать в следующий"s);
+    }
+}
+
+// Тестирование пересчёта IDF после добавления и удаления документов
+void TestInverseDocumentFreqUpdates()
+{
+    SearchServer server(""s);
+    server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "cat bird"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(3, "fish bird"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(4, "frog"s, DocumentStatus::ACTUAL, {1});
+
+    for (const auto& policy_name : {"seq"s, "par"s})
+    {
+        SearchServer copy = server;
+        if (policy_name == "seq"s)
+        {
+            copy.RemoveDocument(std::execution::seq, 1);
+        }
+        else
+        {
+            copy.RemoveDocument(std::execution::par, 1);
+        }
+
+        // Осталось 3 документа, "cat" встречается в одном из них
+        const auto top_docs = copy.FindTopDocuments("cat"s);
+        ASSERT_EQUAL(top_docs.size(), 1u);
+        ASSERT_HINT(abs(top_docs[0].relevance - 0.5 * log(3.0)) < RELEVANCE_ERROR,
+                    "IDF должен учитывать удаление документа: "s + policy_name);
+
+        // Слово удалённого документа больше не находится и не влияет на выдачу
+        ASSERT_HINT(copy.FindTopDocuments("dog"s).empty(), "Слово удалённого документа не должно находиться"s);
+        ASSERT_HINT(copy.FindTopDocuments(search_policy::max_score, "dog"s).empty(), 
+                    "Слово удалённого документа не должно находиться при отсечении MaxScore"s);
+    }
+
+    // IDF пересчитывается при добавлении документа
+    server.AddDocument(5, "cat"s, DocumentStatus::ACTUAL, {1});
+    const auto top_docs = server.FindTopDocuments("bird"s);
+    ASSERT_EQUAL(top_docs.size(), 2u);
+    ASSERT_HINT(abs(top_docs[0].relevance - 0.5 * log(5.0 / 2)) < RELEVANCE_ERROR,
+                "IDF должен учитывать добавление документа"s);
+}
+
+// Тестирование словаря слов и частот слов документа
+void TestTermDictionary()
+{
+    TermDictionary dictionary;
+    ASSERT_EQUAL(dictionary.Find("cat"s), TermDictionary::NO_TERM);
+
+    // Номера выдаются по порядку, повторная вставка возвращает тот же номер, в том числе после роста таблицы
+    vector<string> words;
+    for (int i = 0; i < 1000; ++i)
+    {
+        words.push_back("word"s + to_string(i));
+        ASSERT_EQUAL(dictionary.Insert(words.back()), static_cast<TermId>(i));
+    }
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_EQUAL(dictionary.Insert(words[i]), static_cast<TermId>(i));
+        ASSERT_EQUAL(dictionary.Find(words[i]), static_cast<TermId>(i));
+        ASSERT_EQUAL(dictionary.GetTerm(i), words[i]);
+    }
+
+    // Слова хранятся в словаре, а не ссылаются на исходные строки
+    const TermDictionary copy = dictionary;
+    words.clear();
+    ASSERT_EQUAL(copy.GetTerm(7), "word7"s);
+    ASSERT_EQUAL(copy.size(), 1000u);
+
+    SearchServer server("and"s);
+    {
+        string text = "cat and dog and cat"s;
+        server.AddDocument(1, text, DocumentStatus::ACTUAL, {1});
+        text.assign(text.size(), 'x');
+    }
+    const map<string_view, double> expected = {{"cat"sv, 2.0 / 3}, {"dog"sv, 1.0 / 3}};
+    ASSERT_HINT(server.GetWordFrequencies(1) == expected, "Частоты слов документа вычислены неверно"s);
+    ASSERT_HINT(server.GetWordFrequencies(2).empty(), "У отсутствующего документа нет слов"s);
+}
+
+// Тест проверяет, что стоп-слова не зависят от времени жизни переданных в конструктор строк
+void TestStopWordsOwnership()
+{
+    string stop_words_text = "in the"s;
+    SearchServer server(stop_words_text);
+    stop_words_text.assign(stop_words_text.size(), 'x');
+
+    vector<string> stop_words = {"cat"s};
+    SearchServer vector_server(stop_words);
+    stop_words[0] = "dog"s;
+
+    for (SearchServer* search_server : {&server, &vector_server})
+    {
+        search_server->AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    }
+
+    ASSERT_HINT(server.FindTopDocuments("in"s).empty(), "Стоп-слова из строки должны сохраняться в сервере"s);
+    ASSERT_EQUAL(server.FindTopDocuments("cat"s).size(), 1u);
+    ASSERT_HINT(vector_server.FindTopDocuments("cat"s).empty(), "Стоп-слова из контейнера должны сохраняться в сервере"s);
+
+    // Копия сервера переживает оригинал
+    unique_ptr<SearchServer> original = make_unique<SearchServer>("the"s);
+    original->AddDocument(1, "funny pet"s, DocumentStatus::ACTUAL, {1});
+    SearchServer copy = *original;
+    original.reset();
+    copy.AddDocument(2, "the funny cat"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL(copy.FindTopDocuments("funny the"s).size(), 2u);
+    ASSERT_EQUAL(copy.GetWordFrequencies(1).count("pet"sv), 1u);
+}
+
+// Тестирование пакетного добавления документов
+void TestAddDocuments()
+{
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 200, 6);
+    vector<string> texts;
+    for (int i = 0; i < 300; ++i)
+    {
+        texts.push_back(GenerateQuery(generator, dictionary, 10, 0.0));
+    }
+    const auto queries = GenerateQueries(generator, dictionary, 50, 4);
+
+    SearchServer expected(dictionary[0]);
+    expected.AddDocument(1000, "lonely "s + dictionary[1], DocumentStatus::BANNED, {7});
+    for (size_t i = 0; i < texts.size(); ++i)
+    {
+        expected.AddDocument(i, texts[i], static_cast<DocumentStatus>(i % 4), {static_cast<int>(i), 1});
+    }
+
+    vector<DocumentToAdd> batch;
+    for (size_t i = 0; i < texts.size(); ++i)
+    {
+        batch.push_back({static_cast<int>(i), texts[i], static_cast<DocumentStatus>(i % 4), {static_cast<int>(i), 1}});
+    }
+
+    for (const auto& policy_name : {"seq"s, "par"s})
+    {
+        SearchServer server(dictionary[0]);
+        server.AddDocument(1000, "lonely "s + dictionary[1], DocumentStatus::BANNED, {7});
+        if (policy_name == "seq"s)
+        {
+            server.AddDocuments(std::execution::seq, batch);
+        }
+        else
+        {
+            server.AddDocuments(std::execution::par, batch);
+        }
+
+        ASSERT_EQUAL(server.GetDocumentCount(), expected.GetDocumentCount());
+        for (size_t i = 0; i < texts.size(); ++i)
+        {
+            ASSERT_HINT(server.GetWordFrequencies(i) == expected.GetWordFrequencies(i),
+                        "Частоты слов должны совпадать с последовательным добавлением: "s + policy_name);
+        }
+        for (const string& query : queries)
+        {
+            const auto predicate = [](int, DocumentStatus, int) { return true; };
+            const auto actual_docs = server.FindTopDocuments(query, predicate);
+            const auto expected_docs = expected.FindTopDocuments(query, predicate);
+            AssertSameDocuments(actual_docs, expected_docs);
+        }
+    }
+
+    // Некорректный документ в пакете отменяет добавление всего пакета
+    const vector<vector<DocumentToAdd>> invalid_batches = {
+        {{1, "cat"sv, DocumentStatus::ACTUAL, {1}}, {1, "dog"sv, DocumentStatus::ACTUAL, {1}}},
+        {{1, "cat"sv, DocumentStatus::ACTUAL, {1}}, {1000, "dog"sv, DocumentStatus::ACTUAL, {1}}},
+        {{1, "cat"sv, DocumentStatus::ACTUAL, {1}}, {-2, "dog"sv, DocumentStatus::ACTUAL, {1}}},
+        {{1, "cat"sv, DocumentStatus::ACTUAL, {1}}, {2, "d\x12og"sv, DocumentStatus::ACTUAL, {1}}},
+    };
+    for (const auto& invalid_batch : invalid_batches)
+    {
+        SearchServer server(""s);
+        server.AddDocument(1000, "bird"s, DocumentStatus::ACTUAL, {1});
+        bool is_thrown = false;
+        try
+        {
+            server.AddDocuments(std::execution::par, invalid_batch);
+        }
+        catch (const invalid_argument&)
+        {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, "Некорректный пакет должен приводить к исключению"s);
+        ASSERT_EQUAL(server.GetDocumentCount(), 1);
+        ASSERT_HINT(server.FindTopDocuments("cat"s).empty(), "Документы некорректного пакета не должны добавляться"s);
+    }
+}
+
+// Путь во временном каталоге с номером процесса в имени: параллельные запуски тестов не перезаписывают файлы друг друга
+static string MakeTemporaryPath(const string& file_name)
+{
+    return (filesystem::temp_directory_path() / (file_name + "_"s + to_string(getpid()))).string();
+}
+
+// Тестирование сохранения сервера в снимок и загрузки из него
+void TestSnapshot()
+{
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 300, 8);
+    const auto queries = GenerateQueries(generator, dictionary, 100, 5);
+
+    SearchServer server(dictionary[0] + " "s + dictionary[1]);
+    for (int id = 0; id < 500; ++id)
+    {
+        server.AddDocument(id * 3, GenerateQuery(generator, dictionary, 12, 0.0), 
+                           static_cast<DocumentStatus>(id % 4), {id % 7, -1});
+    }
+    server.RemoveDocument(3);
+    server.RemoveDocument(300);
+
+    const string path = MakeTemporaryPath("search_server_snapshot_test.bin"s);
+    server.SaveSnapshot(path);
+    SearchServer loaded = SearchServer::LoadSnapshot(path);
+
+    ASSERT_EQUAL(loaded.GetDocumentCount(), server.GetDocumentCount());
+    ASSERT_HINT(vector<int>(loaded.begin(), loaded.end()) == vector<int>(server.begin(), server.end()),
+                "Загруженный сервер должен содержать те же документы"s);
+    for (int id : server)
+    {
+        ASSERT(loaded.GetWordFrequencies(id) == server.GetWordFrequencies(id));
+    }
+
+    const auto any_document = [](int, DocumentStatus, int) { return true; };
+    for (const string& query : queries)
+    {
+        for (const auto& [expected, actual] : {
+                 pair{server.FindTopDocuments(query, any_document), loaded.FindTopDocuments(query, any_document)},
+                 pair{server.FindTopDocuments(search_policy::max_score, query), 
+                      loaded.FindTopDocuments(search_policy::max_score, query)}})
+        {
+            AssertSameDocuments(actual, expected);
+        }
+        ASSERT(loaded.MatchDocument(query, 6) == server.MatchDocument(query, 6));
+    }
+
+    // Снимок с надгробиями побайтно совпадает со снимком очищенного сервера
+    {
+        const auto read_file = [](const string& file_path) {
+            ifstream in(file_path, ios::binary);
+            return string((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        };
+        const string snapshot = read_file(path);
+        SearchServer purged = server;
+        purged.PurgeRemovedDocuments();
+        purged.SaveSnapshot(path);
+        ASSERT(read_file(path) == snapshot);
+    }
+
+    // Загруженный сервер продолжает работу: стоп-слова и словарь восстановлены
+    loaded.AddDocument(3, dictionary[0] + " unique"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL(loaded.FindTopDocuments("unique"s).size(), 1u);
+    ASSERT_HINT(loaded.FindTopDocuments(dictionary[0]).empty(), "Стоп-слова должны загружаться из снимка"s);
+
+    // Обрезанный и чужой файлы отвергаются
+    const auto expect_error = [](const string& file_path, const string& hint) {
+        bool is_thrown = false;
+        try
+        {
+            SearchServer::LoadSnapshot(file_path);
+        }
+        catch (const runtime_error&)
+        {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, hint);
+    };
+
+    // Снимок с испорченным байтом того же размера либо отвергается, либо загружается в согласованный сервер
+    {
+        SearchServer small_server("and"s);
+        for (int id = 0; id < 70; ++id)
+        {
+            small_server.AddDocument(id * 3, dictionary[id % 7] + " "s + dictionary[id % 11] + " and "s + dictionary[id % 13],
+                                     static_cast<DocumentStatus>(id % 4), {id});
+        }
+        small_server.SaveSnapshot(path);
+        ifstream in(path, ios::binary);
+        const string original((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        in.close();
+        for (size_t position = 0; position < original.size(); ++position)
+        {
+            for (const char corruption : {'\x80', '\xff'})
+            {
+                string corrupted = original;
+                corrupted[position] ^= corruption;
+                {
+                    ofstream out(path, ios::binary | ios::trunc);
+                    out << corrupted;
+                }
+                try
+                {
+                    SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+                    for (const string& query : vector<string>(queries.begin(), queries.begin() + 10))
+                    {
+                        loaded_server.FindTopDocuments(std::execution::par, query, [](int, DocumentStatus, int) { return true; });
+                        loaded_server.FindTopDocuments(search_policy::max_score, query);
+                    }
+                    for (const int document_id : vector<int>(loaded_server.begin(), loaded_server.end()))
+                    {
+                        loaded_server.RemoveDocument(document_id);
+                    }
+                }
+                catch (const runtime_error&)
+                {
+                }
+            }
+        }
+    }
+
+    filesystem::resize_file(path, filesystem::file_size(path) - 1);
+    expect_error(path, "Обрезанный снимок должен приводить к исключению"s);
+    {
+        ofstream out(path, ios::binary | ios::trunc);
+        out << "not a snapshot"s;
+    }
+    expect_error(path, "Файл без заголовка снимка должен приводить к исключению"s);
+
+    // Пустой список вхождений с ненулевыми последним id или максимальной частотой отвергается
+    for (const auto& [last_document_id, max_term_freq] : {pair{7, 0.0}, pair{0, 0.5}})
+    {
+        {
+            SnapshotWriter writer(path);
+            writer.WriteArray(vector<uint8_t>{});
+            writer.WriteArray(vector<double>{});
+            writer.WriteArray(vector<uint8_t>{});
+            writer.WriteValue(last_document_id);
+            writer.WriteValue(max_term_freq);
+            writer.Finish();
+        }
+        const MappedFile file(path);
+        SnapshotReader reader(file.data(), file.size());
+        PostingList postings;
+        bool is_thrown = false;
+        try
+        {
+            postings.Load(reader);
+        }
+        catch (const runtime_error&)
+        {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, "Пустой список вхождений с мусором в полях должен приводить к исключению"s);
+    }
+
+    filesystem::remove(path);
+    expect_error(path, "Отсутствующий файл должен приводить к исключению"s);
+}
+
+// Тестирование потоковой загрузки корпуса из файла
+void TestIngestCorpus()
+{
+    const DocumentToAdd parsed = ParseCorpusLine("12\tBANNED\t5 -3 7\tfunny cat"sv);
+    ASSERT_EQUAL(parsed.id, 12);
+    ASSERT(parsed.status == DocumentStatus::BANNED);
+    ASSERT(parsed.ratings == vector<int>({5, -3, 7}));
+    ASSERT_EQUAL(parsed.text, "funny cat"sv);
+
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 100, 6);
+    const auto queries = GenerateQueries(generator, dictionary, 30, 3);
+    const vector<string> status_names = {"ACTUAL"s, "IRRELEVANT"s, "BANNED"s, "REMOVED"s};
+
+    SearchServer expected("and in"s);
+    const string path = MakeTemporaryPath("search_server_corpus_test.txt"s);
+    {
+        ofstream out(path, ios::binary);
+        for (int id = 0; id < 200; ++id)
+        {
+            const string text = GenerateQuery(generator, dictionary, 1 + id % 20, 0.0);
+            expected.AddDocument(id, text, static_cast<DocumentStatus>(id % 4), {id, 2});
+            // Пустые строки и окончания \r\n допустимы, последняя строка без перевода строки
+            out << id << '\t' << status_names[id % 4] << '\t' << id << ' ' << 2 << '\t' << text;
+            if (id + 1 < 200)
+            {
+                out << (id % 3 == 0 ? "\r\n"s : "\n"s) << (id % 10 == 0 ? "\n"s : ""s);
+            }
+        }
+    }
+
+    // Маленький блок заставляет переносить строки между блоками и увеличивать буфер
+    for (size_t chunk_size : {size_t{16}, size_t{1000}, DEFAULT_CORPUS_CHUNK_SIZE})
+    {
+        SearchServer server("and in"s);
+        ASSERT_EQUAL(IngestCorpus(server, path, chunk_size), 200u);
+        ASSERT_EQUAL(server.GetDocumentCount(), 200);
+        for (int id = 0; id < 200; ++id)
+        {
+            ASSERT(server.GetWordFrequencies(id) == expected.GetWordFrequencies(id));
+        }
+        for (const string& query : queries)
+        {
+            const auto predicate = [](int, DocumentStatus, int) { return true; };
+            const auto actual_docs = server.FindTopDocuments(query, predicate);
+            const auto expected_docs = expected.FindTopDocuments(query, predicate);
+            AssertSameDocuments(actual_docs, expected_docs);
+        }
+    }
+
+    // Ошибка формата сообщает номер строки
+    {
+        ofstream out(path, ios::binary | ios::trunc);
+        out << "1\tACTUAL\t1\tcat\n2\tUNKNOWN\t1\tdog\n"s;
+    }
+    SearchServer server(""s);
+    string message;
+    try
+    {
+        IngestCorpus(server, path);
+    }
+    catch (const invalid_argument& e)
+    {
+        message = e.what();
+    }
+    ASSERT_HINT(message.find("Строка корпуса 2:"s) != string::npos, "Сообщение об ошибке должно содержать номер строки"s);
+    ASSERT_EQUAL(server.GetDocumentCount(), 0);
+    filesystem::remove(path);
+}
+
+// Тестирование векторного разбиения текста на слова
+void TestSplitIntoWords()
+{
+    const auto split_reference = [](string_view text, bool& is_valid) {
+        vector<string_view> words;
+        is_valid = true;
+        size_t word_start = string_view::npos;
+        for (size_t i = 0; i <= text.size(); ++i)
+        {
+            if (i < text.size() && static_cast<unsigned char>(text[i]) < ' ')
+            {
+                is_valid = false;
+            }
+            if (i == text.size() || text[i] == ' ')
+            {
+                if (word_start != string_view::npos)
+                {
+                    words.push_back(text.substr(word_start, i - word_start));
+                    word_start = string_view::npos;
+                }
+            }
+            else if (word_start == string_view::npos)
+            {
+                word_start = i;
+            }
+        }
+        return words;
+    };
+
+    // Тексты разной длины проверяют границы слов внутри блоков, на их стыках и в хвосте
+    mt19937 generator;
+    const string alphabet = "  ab\x01\x1f\x7f\x80\xff\t"s;
+    for (int iteration = 0; iteration < 2000; ++iteration)
+    {
+        const bool has_special = iteration % 4 == 0;
+        string text(uniform_int_distribution(0, 150)(generator), ' ');
+        for (char& c : text)
+        {
+            c = alphabet[uniform_int_distribution<size_t>(0, has_special ? alphabet.size() - 1 : 3)(generator)];
+        }
+
+        bool expected_valid = true;
+        const vector<string_view> expected_words = split_reference(text, expected_valid);
+        vector<string_view> words = {"prefix"sv};
+        const bool is_valid = SplitIntoWordsAndValidate(text, words);
+
+        ASSERT_EQUAL(is_valid, expected_valid);
+        ASSERT_EQUAL(words.front(), "prefix"sv);
+        ASSERT_HINT(vector<string_view>(words.begin() + 1, words.end()) == expected_words, 
+                    "Разбиение на слова не совпадает с побайтовым"s);
+    }
+
+    ASSERT(SplitIntoWords(""s).empty());
+    ASSERT(SplitIntoWords("      "s).empty());
+    const string long_word(40, 'x');
+    const auto long_words = SplitIntoWords(long_word);
+    ASSERT_EQUAL(long_words.size(), 1u);
+    ASSERT_EQUAL(long_words[0], long_word);
+}
+
+// Тестирование разбора запроса: повторы слов, стоп-слова и ошибки формата
+void TestParseQuery()
+{
+    SearchServer server("in the"s);
+    server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    server.AddDocument(2, "dog in the city"s, DocumentStatus::ACTUAL, {2});
+    server.AddDocument(3, "bird"s, DocumentStatus::ACTUAL, {3});
+
+    // Повторённое слово учитывается один раз
+    const auto single = server.FindTopDocuments("cat"s);
+    const auto repeated = server.FindTopDocuments("cat cat  cat"s);
+    ASSERT_EQUAL(repeated.size(), 1u);
+    ASSERT(abs(repeated[0].relevance - single[0].relevance) < RELEVANCE_ERROR);
+
+    // Совпавшие слова возвращаются упорядоченными и без повторов
+    const string match_query = "city cat the city -dog -dog"s;
+    const auto [words, status] = server.MatchDocument(match_query, 1);
+    ASSERT(words == vector<string_view>({"cat"sv, "city"sv}));
+
+    // Стоп-слово с минусом игнорируется
+    ASSERT_EQUAL(server.FindTopDocuments("city -in"s).size(), 2u);
+    ASSERT_EQUAL(server.FindTopDocuments("city -dog"s).size(), 1u);
+
+    for (const string& query : {"cat -"s, "cat --dog"s, "ca\x01t"s, "cat -do\x1fg"s})
+    {
+        bool is_thrown = false;
+        try
+        {
+            server.FindTopDocuments(query);
+        }
+        catch (const invalid_argument&)
+        {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, "Некорректный запрос должен приводить к исключению"s);
+    }
+}
+
+// Тестирование вектора со встроенным буфером
+void TestSmallVector()
+{
+    SmallVector<int, 4> items;
+    ASSERT(items.empty());
+    for (int i = 0; i < 4; ++i)
+    {
+        items.push_back(i);
+    }
+    ASSERT_HINT(items.IsInline(), "Элементы в пределах встроенной ёмкости не должны выделять память"s);
+
+    // Переполнение переносит элементы в кучу с сохранением порядка
+    for (int i = 4; i < 10; ++i)
+    {
+        items.push_back(i);
+    }
+    ASSERT(!items.IsInline());
+    ASSERT(vector<int>(items.begin(), items.end()) == vector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+    // Копия независима от оригинала
+    SmallVector<int, 4> copy = items;
+    copy[0] = 100;
+    ASSERT_EQUAL(items[0], 0);
+
+    items.erase(items.begin() + 2, items.begin() + 8);
+    ASSERT(vector<int>(items.begin(), items.end()) == vector<int>({0, 1, 8, 9}));
+
+    items.clear();
+    items.push_back(7);
+    items.push_back(7);
+    items.push_back(3);
+    ASSERT(items.IsInline());
+    sort(items.begin(), items.end());
+    items.erase(unique(items.begin(), items.end()), items.end());
+    ASSERT(vector<int>(items.begin(), items.end()) == vector<int>({3, 7}));
+
+    const SmallVector<int, 4> moved = move(copy);
+    ASSERT_EQUAL(moved.size(), 10u);
+    ASSERT_EQUAL(moved[0], 100);
+    ASSERT_EQUAL(moved[9], 9);
+
+    // Перемещённый вектор пуст и пригоден для дальнейшего использования
+    ASSERT(copy.empty() && copy.IsInline() && copy.begin() == copy.end());
+    copy.push_back(1);
+    ASSERT(vector<int>(copy.begin(), copy.end()) == vector<int>({1}));
+    SmallVector<int, 4> inline_items;
+    inline_items.push_back(5);
+    inline_items.push_back(6);
+    copy = move(inline_items);
+    ASSERT(copy.IsInline() && vector<int>(copy.begin(), copy.end()) == vector<int>({5, 6}));
+    ASSERT(inline_items.empty());
+}
+
+// Тестирование фильтра стоп-слов
+void TestStopWordFilter()
+{
+    ASSERT(!StopWordFilter().Contains("in"sv));
+    ASSERT(!StopWordFilter().Contains(""sv));
+
+    // Длинные слова с общим началом из 8 символов различаются полным сравнением
+    const vector<string> words = {"a"s, "in"s, "on"s, "the"s, "in"s, ""s, "abcdefgh"s, 
+                                  "abcdefghij"s, "abcdefghik"s, "abcdefghijklmnop"s};
+    const StopWordFilter filter(vector<string_view>(words.begin(), words.end()));
+    ASSERT_EQUAL(filter.size(), 8u);
+
+    for (const string& word : words)
+    {
+        ASSERT_EQUAL(filter.Contains(word), !word.empty());
+    }
+    for (string_view word : {"an"sv, "i"sv, "b"sv, "then"sv, "abcdefgi"sv, "abcdefghii"sv, "abcdefghijk"sv, 
+                             "abcdefghijklmnoq"sv, "abcdefghijklmnopq"sv, "the "sv, ""sv})
+    {
+        ASSERT_HINT(!filter.Contains(word), "Слово не должно считаться стоп-словом: "s + string(word));
+    }
+
+    // Результат совпадает с хеш-множеством на случайных словах
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 2000, 12);
+    const vector<string_view> stop_words(dictionary.begin(), dictionary.begin() + 300);
+    const StopWordFilter random_filter(stop_words);
+    const unordered_set<string_view> expected(stop_words.begin(), stop_words.end());
+    for (string_view word : dictionary)
+    {
+        ASSERT_EQUAL(random_filter.Contains(word), expected.count(word) > 0);
+    }
+}
+
+// Тестирование поиска с переиспользуемым контекстом
+void TestSearchContext()
+{
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 200, 6);
+    vector<string> queries;
+    for (int i = 0; i < 100; ++i)
+    {
+        queries.push_back(GenerateQuery(generator, dictionary, 4, 0.2));
+    }
+
+    SearchServer small_server(dictionary[0]);
+    SearchServer large_server(dictionary[0]);
+    for (int id = 0; id < 1000; ++id)
+    {
+        const string text = GenerateQuery(generator, dictionary, 15, 0.0);
+        if (id < 50)
+        {
+            small_server.AddDocument(id, text, static_cast<DocumentStatus>(id % 4), {id});
+        }
+        large_server.AddDocument(id, text, static_cast<DocumentStatus>(id % 4), {id});
+    }
+
+    // Один контекст поочерёдно используется серверами разного размера и разными политиками
+    SearchContext context;
+    const auto even_ids = [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; };
+    for (const string& query : queries)
+    {
+        for (const SearchServer* server : {&large_server, &small_server})
+        {
+            AssertSameDocuments(server->FindTopDocuments(context, query), server->FindTopDocuments(query));
+            AssertSameDocuments(server->FindTopDocuments(context, query, DocumentStatus::BANNED), 
+                        server->FindTopDocuments(query, DocumentStatus::BANNED));
+            AssertSameDocuments(server->FindTopDocuments(context, std::execution::par, query, even_ids, 2, 4),
+                        server->FindTopDocuments(std::execution::seq, query, even_ids, 2, 4));
+            AssertSameDocuments(server->FindTopDocuments(context, search_policy::max_score, query, even_ids, 1, 6),
+                        server->FindTopDocuments(std::execution::seq, query, even_ids, 1, 6));
+        }
+    }
+
+    // Результат хранится в контексте до следующего поиска
+    const vector<Document>& result = large_server.FindTopDocuments(context, queries[0]);
+    const vector<Document> expected = result;
+    large_server.FindTopDocuments(context, queries[1]);
+    AssertSameDocuments(large_server.FindTopDocuments(context, queries[0]), expected);
+
+    // Освобождённый контекст пула достаётся следующему запросу, копия сервера получает собственный пул
+    const SearchContext* released_context = nullptr;
+    {
+        const auto pooled_context = large_server.AcquireSearchContext();
+        AssertSameDocuments(large_server.FindTopDocuments(*pooled_context, queries[0]), expected);
+        released_context = pooled_context.get();
+    }
+    ASSERT(large_server.AcquireSearchContext().get() == released_context);
+    const SearchServer copy = large_server;
+    AssertSameDocuments(copy.FindTopDocuments(queries[0]), expected);
+}
+
+// Тестирование пула потоков и исполнителя пакетов запросов
+void TestQueryExecutor()
+{
+    {
+        // Каждый индекс обрабатывается ровно один раз, в том числе во вложенных вызовах
+        ThreadPool pool(3);
+        vector<atomic<int>> visits(100);
+        pool.ParallelFor(10, [&](size_t outer) {
+            pool.ParallelFor(10, [&](size_t inner) { ++visits[outer * 10 + inner]; });
+        });
+        ASSERT(all_of(visits.begin(), visits.end(), [](const atomic<int>& count) { return count == 1; }));
+
+        bool is_thrown = false;
+        try
+        {
+            pool.ParallelFor(20, [](size_t i) {
+                if (i == 7)
+                {
+                    throw runtime_error("ошибка задачи"s);
+                }
+            });
+        }
+        catch (const runtime_error&)
+        {
+            is_thrown = true;
+        }
+        ASSERT(is_thrown);
+    }
+
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 200, 6);
+    SearchServer server(dictionary[0]);
+    for (int id = 0; id < 1000; ++id)
+    {
+        server.AddDocument(id, GenerateQuery(generator, dictionary, 15, 0.0), static_cast<DocumentStatus>(id % 4), {id});
+    }
+    vector<string> queries;
+    for (int i = 0; i < 200; ++i)
+    {
+        queries.push_back(GenerateQuery(generator, dictionary, i % 10 == 0 ? 40 : 4, 0.1));
+    }
+
+    vector<vector<Document>> expected;
+    for (const string& query : queries)
+    {
+        expected.push_back(server.FindTopDocuments(query));
+    }
+
+    // Размер пула и порог тяжёлого запроса не влияют на результат
+    for (const auto& [thread_count, heavy_query_word_count] : {pair<size_t, size_t>{1, 32}, {3, 32}, {3, 1}, {4, 1000}})
+    {
+        QueryExecutor executor(thread_count, heavy_query_word_count);
+        ASSERT_EQUAL(executor.GetThreadCount(), thread_count);
+        const auto results = executor.ProcessQueries(server, queries);
+        ASSERT_EQUAL(results.size(), queries.size());
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            AssertSameDocuments(results[i], expected[i]);
+        }
+        AssertSameDocuments(server.FindTopDocuments(search_policy::on(executor.GetPool()), queries[0]), expected[0]);
+    }
+
+    ASSERT(QueryExecutor(2).ProcessQueries(server, {}).empty());
+    const auto default_results = ProcessQueries(server, queries);
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        AssertSameDocuments(default_results[i], expected[i]);
+    }
+}
+
+// Тестирование объединённых результатов пакета запросов
+void TestProcessQueriesJoined()
+{
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 100, 6);
+    SearchServer server(dictionary[0]);
+    for (int id = 0; id < 300; ++id)
+    {
+        server.AddDocument(id, GenerateQuery(generator, dictionary, 10, 0.0), static_cast<DocumentStatus>(id % 2), {id});
+    }
+    // Среди запросов есть пустые выдачи: несуществующее слово и одни минус-слова
+    vector<string> queries = {"несуществующее"s, "-"s + dictionary[1]};
+    for (int i = 0; i < 100; ++i)
+    {
+        queries.push_back(GenerateQuery(generator, dictionary, i % 7 == 0 ? 40 : 3, 0.2));
+    }
+
+    for (const size_t thread_count : {1, 3})
+    {
+        QueryExecutor executor(thread_count, 20);
+        const JoinedQueryResults joined = executor.ProcessQueriesJoined(server, queries);
+        const auto expected = executor.ProcessQueries(server, queries);
+        ASSERT_EQUAL(joined.GetQueryCount(), queries.size());
+        ASSERT_EQUAL(joined.GetOffsets().size(), queries.size() + 1);
+
+        vector<Document> expected_flat;
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            const auto query_results = joined.GetQueryResults(i);
+            ASSERT_EQUAL(static_cast<size_t>(query_results.size()), expected[i].size());
+            ASSERT(equal(query_results.begin(), query_results.end(), expected[i].begin(),
+                         [](const Document& lhs, const Document& rhs) { return lhs.id == rhs.id && lhs.relevance == rhs.relevance; }));
+            expected_flat.insert(expected_flat.end(), expected[i].begin(), expected[i].end());
+        }
+        ASSERT(joined.GetQueryResults(0).size() == 0);
+        ASSERT_EQUAL(joined.size(), expected_flat.size());
+        ASSERT(equal(joined.begin(), joined.end(), expected_flat.begin(),
+                     [](const Document& lhs, const Document& rhs) { return lhs.id == rhs.id; }));
+    }
+
+    const JoinedQueryResults empty = ProcessQueriesJoined(server, {});
+    ASSERT_EQUAL(empty.GetQueryCount(), 0u);
+    ASSERT(empty.empty());
+}
+
+// Тестирование асинхронного поиска через исполнитель запросов
+void TestFindTopDocumentsAsync()
+{
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 100, 6);
+    SearchServer server(dictionary[0]);
+    for (int id = 0; id < 300; ++id)
+    {
+        server.AddDocument(id, GenerateQuery(generator, dictionary, 10, 0.0), static_cast<DocumentStatus>(id % 3), {id});
+    }
+    vector<string> queries;
+    for (int i = 0; i < 300; ++i)
+    {
+        queries.push_back(GenerateQuery(generator, dictionary, i % 10 == 0 ? 40 : 3, 0.2));
+    }
+
+    QueryExecutor executor(2, 20);
+    const auto odd_ids = [](int document_id, DocumentStatus, int) { return document_id % 2 == 1; };
+
+    // Все запросы ставятся в очередь до получения первого результата
+    vector<future<vector<Document>>> actual_futures;
+    vector<future<vector<Document>>> banned_futures;
+    vector<future<vector<Document>>> odd_futures;
+    for (const string& query : queries)
+    {
+        actual_futures.push_back(executor.FindTopDocumentsAsync(server, query));
+        banned_futures.push_back(executor.FindTopDocumentsAsync(server, query, DocumentStatus::BANNED));
+        odd_futures.push_back(executor.FindTopDocumentsAsync(server, query, odd_ids));
+    }
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        AssertSameDocuments(actual_futures[i].get(), server.FindTopDocuments(queries[i]));
+        AssertSameDocuments(banned_futures[i].get(), server.FindTopDocuments(queries[i], DocumentStatus::BANNED));
+        AssertSameDocuments(odd_futures[i].get(), server.FindTopDocuments(queries[i], odd_ids));
+    }
+
+    // Исключение поиска передаётся через future
+    auto invalid_future = executor.FindTopDocumentsAsync(server, "--"s + dictionary[1]);
+    bool is_thrown = false;
+    try
+    {
+        invalid_future.get();
+    }
+    catch (const invalid_argument&)
+    {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+
+    // Ошибки разбора и частей тяжёлого запроса также передаются через future
+    auto invalid_heavy_future = executor.FindTopDocumentsAsync(server, queries[0] + " --"s + dictionary[1]);
+    auto throwing_heavy_future = executor.FindTopDocumentsAsync(server, queries[0], [](int, DocumentStatus, int) -> bool {
+        throw out_of_range("predicate"s);
+    });
+    is_thrown = false;
+    try
+    {
+        invalid_heavy_future.get();
+    }
+    catch (const invalid_argument&)
+    {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    is_thrown = false;
+    try
+    {
+        throwing_heavy_future.get();
+    }
+    catch (const out_of_range&)
+    {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+
+    // Исполнитель выполняет поставленные запросы, в том числе части тяжёлых, до разрушения
+    future<vector<Document>> pending_future;
+    future<vector<Document>> pending_heavy_future;
+    {
+        QueryExecutor short_lived_executor(1);
+        pending_future = short_lived_executor.FindTopDocumentsAsync(server, queries[1]);
+        pending_heavy_future = short_lived_executor.FindTopDocumentsAsync(server, queries[0]);
+    }
+    AssertSameDocuments(pending_future.get(), server.FindTopDocuments(queries[1]));
+    AssertSameDocuments(pending_heavy_future.get(), server.FindTopDocuments(queries[0]));
+
+    // Сервер можно разрушить сразу после получения результата лёгкого и тяжёлого запроса
+    for (int i = 0; i < 200; ++i)
+    {
+        const string& query = queries[i % 2];
+        auto short_lived_server = make_unique<SearchServer>(dictionary[0]);
+        for (int id = 0; id < 30; ++id)
+        {
+            short_lived_server->AddDocument(id, GenerateQuery(generator, dictionary, 10, 0.0), DocumentStatus::ACTUAL, {id});
+        }
+        const vector<Document> expected = short_lived_server->FindTopDocuments(query);
+        auto short_lived_future = executor.FindTopDocumentsAsync(*short_lived_server, query);
+        const vector<Document> actual = short_lived_future.get();
+        short_lived_server.reset();
+        AssertSameDocuments(actual, expected);
+    }
+}
+
+// Тестирование изменения индекса во время выполнения запросов
+void TestConcurrentSearchServer()
+{
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 100, 6);
+    vector<string> texts;
+    for (int id = 0; id < 200; ++id)
+    {
+        texts.push_back(GenerateQuery(generator, dictionary, 10, 0.0));
+    }
+    vector<string> queries;
+    for (int i = 0; i < 20; ++i)
+    {
+        queries.push_back(GenerateQuery(generator, dictionary, 3, 0.0));
+    }
+
+    const auto make_batch = [&texts](int begin, int end) {
+        vector<DocumentToAdd> batch;
+        for (int id = begin; id < end; ++id)
+        {
+            batch.push_back({id, texts[id], DocumentStatus::ACTUAL, {id}});
+        }
+        return batch;
+    };
+
+    ConcurrentSearchServer server(dictionary[0], 16, 3);
+    server.AddDocuments(make_batch(0, 50));
+
+    atomic<bool> is_writing{true};
+    atomic<int> error_count{0};
+    auto read = [&] {
+        int previous_count = 0;
+        const auto any_document = [](int, DocumentStatus, int) { return true; };
+        while (is_writing)
+        {
+            for (const string& query : queries)
+            {
+                const int document_count = server.GetDocumentCount();
+                // Документы добавляются подряд, а удаляются только после добавления всех
+                if (document_count < previous_count && previous_count <= 50)
+                {
+                    ++error_count;
+                }
+                previous_count = document_count;
+                for (const auto& documents : {server.FindTopDocuments(query),
+                                              server.FindTopDocuments(std::execution::par, query, any_document, 5, 10)})
+                {
+                    for (const Document& document : documents)
+                    {
+                        if (document.id < 0 || document.id >= static_cast<int>(texts.size()))
+                        {
+                            ++error_count;
+                        }
+                    }
+                }
+                // Нечётные документы первого пакета не удаляются
+                if (get<1>(server.MatchDocument(query, 1)) != DocumentStatus::ACTUAL)
+                {
+                    ++error_count;
+                }
+            }
+        }
+    };
+    thread first_reader(read);
+    thread second_reader(read);
+
+    for (int id = 50; id < 150; id += 10)
+    {
+        server.AddDocuments(make_batch(id, id + 10));
+    }
+    for (int id = 150; id < 200; ++id)
+    {
+        server.AddDocument(id, texts[id], DocumentStatus::ACTUAL, {id});
+    }
+    server.RemoveDocuments({0, 2});
+    for (int id = 4; id < 100; id += 2)
+    {
+        server.RemoveDocument(id);
+    }
+    vector<int> removed_ids;
+    for (int id = 100; id < 200; id += 2)
+    {
+        removed_ids.push_back(id);
+    }
+    server.RemoveDocuments(removed_ids);
+    is_writing = false;
+    first_reader.join();
+    second_reader.join();
+    ASSERT_EQUAL(error_count.load(), 0);
+
+    // Итоговая версия совпадает с сервером, построенным без конкурентного доступа
+    SearchServer expected(dictionary[0]);
+    for (int id = 1; id < 200; id += 2)
+    {
+        expected.AddDocument(id, texts[id], DocumentStatus::ACTUAL, {id});
+    }
+    ASSERT_EQUAL(server.GetDocumentCount(), 100);
+    for (const string& query : queries)
+    {
+        AssertSameDocuments(server.FindTopDocuments(query), expected.FindTopDocuments(query));
+        ASSERT(server.MatchDocument(query, 51) == expected.MatchDocument(query, 51));
+    }
+
+    // Неудачный пакет не публикуется ни частично, ни целиком
+    for (const vector<DocumentToAdd>& invalid_batch : {
+             vector<DocumentToAdd>{{1000, texts[0], DocumentStatus::ACTUAL, {}}, {1, "повтор"sv, DocumentStatus::ACTUAL, {}}},
+             vector<DocumentToAdd>{{1000, texts[0], DocumentStatus::ACTUAL, {}}, {1001, "спец\x12символ"sv, DocumentStatus::ACTUAL, {}}}})
+    {
+        bool is_thrown = false;
+        try
+        {
+            server.AddDocuments(invalid_batch);
+        }
+        catch (const invalid_argument&)
+        {
+            is_thrown = true;
+        }
+        ASSERT(is_thrown);
+        ASSERT_EQUAL(server.GetDocumentCount(), 100);
+    }
+    server.AddDocuments({{1000, texts[0], DocumentStatus::ACTUAL, {}}});
+    ASSERT_EQUAL(server.GetDocumentCount(), 101);
+}
+
+// Тестирование индекса из сегментов с фоновым слиянием
+void TestSegmentedSearchServer()
+{
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 100, 6);
+    vector<string> texts;
+    for (int id = 0; id < 300; ++id)
+    {
+        texts.push_back(GenerateQuery(generator, dictionary, 10, 0.0));
+    }
+    vector<string> queries;
+    for (int i = 0; i < 30; ++i)
+    {
+        queries.push_back(GenerateQuery(generator, dictionary, 4, 0.2));
+    }
+
+    SegmentedSearchServer segmented(dictionary[0], 10, 3);
+    SearchServer expected(dictionary[0]);
+    for (int id = 0; id < 295; ++id)
+    {
+        segmented.AddDocument(id, texts[id], static_cast<DocumentStatus>(id % 3), {id});
+        expected.AddDocument(id, texts[id], static_cast<DocumentStatus>(id % 3), {id});
+    }
+    segmented.WaitForMerges();
+    // Уровни по 10, 30, 90 и 270 документов, на каждом меньше трёх сегментов
+    ASSERT(segmented.GetSegmentCount() <= 8);
+    ASSERT_EQUAL(segmented.GetDocumentCount(), expected.GetDocumentCount());
+
+    // Релевантность считается по статистике всего индекса, а не отдельных сегментов
+    const auto even_ids = [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; };
+    for (const string& query : queries)
+    {
+        AssertSameDocuments(segmented.FindTopDocuments(query), expected.FindTopDocuments(query));
+        AssertSameDocuments(segmented.FindTopDocuments(query, DocumentStatus::BANNED), expected.FindTopDocuments(query, DocumentStatus::BANNED));
+        AssertSameDocuments(segmented.FindTopDocuments(query, even_ids), expected.FindTopDocuments(query, even_ids));
+    }
+
+    bool is_thrown = false;
+    try
+    {
+        segmented.AddDocument(5, "повтор"s, DocumentStatus::ACTUAL, {});
+    }
+    catch (const invalid_argument&)
+    {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+
+    // Удаление из сегментов и из буфера записи; удалённый id можно добавить заново
+    for (int id = 0; id < 295; id += 4)
+    {
+        segmented.RemoveDocument(id);
+        expected.RemoveDocument(id);
+    }
+    segmented.RemoveDocument(292);
+    expected.RemoveDocument(292);
+    segmented.AddDocument(0, texts[295], DocumentStatus::ACTUAL, {7});
+    expected.AddDocument(0, texts[295], DocumentStatus::ACTUAL, {7});
+    ASSERT_EQUAL(segmented.GetDocumentCount(), expected.GetDocumentCount());
+    // Надгробия не учитываются в статистике ещё до слияния их сегментов
+    for (const string& query : queries)
+    {
+        AssertSameDocuments(segmented.FindTopDocuments(query), expected.FindTopDocuments(query));
+        AssertSameDocuments(segmented.FindTopDocuments(query, even_ids), expected.FindTopDocuments(query, even_ids));
+    }
+
+    // Окно выдачи, политики выполнения и MatchDocument работают поверх сегментов, надгробий и буфера записи
+    const auto any_document = [](int, DocumentStatus, int) { return true; };
+    for (const string& query : queries)
+    {
+        for (const int offset : {0, 7, 40})
+        {
+            const auto expected_window = expected.FindTopDocuments(std::execution::seq, query, any_document, offset, 15);
+            AssertSameDocuments(segmented.FindTopDocuments(std::execution::seq, query, any_document, offset, 15), expected_window);
+            AssertSameDocuments(segmented.FindTopDocuments(std::execution::par, query, any_document, offset, 15), expected_window);
+            AssertSameDocuments(segmented.FindTopDocuments(search_policy::max_score, query, any_document, offset, 15),
+                                expected_window);
+        }
+        AssertSameDocuments(segmented.FindTopDocuments(std::execution::par, query, DocumentStatus::BANNED),
+                            expected.FindTopDocuments(query, DocumentStatus::BANNED));
+        for (const int id : {0, 1, 150, 291, 293})
+        {
+            ASSERT(segmented.MatchDocument(query, id) == expected.MatchDocument(query, id));
+            ASSERT(segmented.MatchDocument(std::execution::par, query, id) == expected.MatchDocument(query, id));
+        }
+    }
+    for (const int removed_id : {4, 292, 1000})
+    {
+        is_thrown = false;
+        try
+        {
+            segmented.MatchDocument(queries[0], removed_id);
+        }
+        catch (const out_of_range&)
+        {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, "MatchDocument удалённого документа должен приводить к исключению"s);
+    }
+
+    // Массовое удаление по одному и пакетом: надгробия сегментов копятся порциями, и выдача
+    // остаётся прежней; отсутствующие и повторяющиеся id пакета пропускаются
+    for (int id = 1; id < 150; id += 2)
+    {
+        segmented.RemoveDocument(id);
+        expected.RemoveDocument(id);
+    }
+    vector<int> batch_ids{1000, 151, 151};
+    for (int id = 151; id < 295; id += 3)
+    {
+        batch_ids.push_back(id);
+    }
+    segmented.RemoveDocuments(batch_ids);
+    expected.RemoveDocuments(batch_ids);
+    segmented.RemoveDocuments({});
+    ASSERT_EQUAL(segmented.GetDocumentCount(), expected.GetDocumentCount());
+    for (const string& query : queries)
+    {
+        AssertSameDocuments(segmented.FindTopDocuments(query), expected.FindTopDocuments(query));
+        AssertSameDocuments(segmented.FindTopDocuments(query, even_ids), expected.FindTopDocuments(query, even_ids));
+    }
+    is_thrown = false;
+    try
+    {
+        segmented.AddDocument(2, "повтор"s, DocumentStatus::ACTUAL, {});
+    }
+    catch (const invalid_argument&)
+    {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+
+    // После полного слияния надгробия исчезают физически
+    segmented.Compact();
+    ASSERT_EQUAL(segmented.GetSegmentCount(), 1u);
+    ASSERT_EQUAL(segmented.GetDocumentCount(), expected.GetDocumentCount());
+    for (const string& query : queries)
+    {
+        AssertSameDocuments(segmented.FindTopDocuments(query), expected.FindTopDocuments(query));
+    }
+}
+
+// Тестирование отложенного удаления документов с последующей очисткой
+void TestDeferredRemoval()
+{
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 300, 6);
+    vector<string> texts;
+    for (int id = 0; id < 3000; ++id)
+    {
+        texts.push_back(GenerateQuery(generator, dictionary, 10, 0.0));
+    }
+    vector<string> queries;
+    for (int i = 0; i < 50; ++i)
+    {
+        queries.push_back(GenerateQuery(generator, dictionary, 4, 0.2));
+    }
+
+    // Выдача сервера с удалёнными документами совпадает с выдачей сервера, где их не было
+    const auto check_same_as_fresh = [&](const SearchServer& server, const auto& is_removed) {
+        SearchServer fresh(dictionary[0]);
+        for (int id = 0; id < static_cast<int>(texts.size()); ++id)
+        {
+            if (!is_removed(id))
+            {
+                fresh.AddDocument(id, texts[id], static_cast<DocumentStatus>(id % 2), {id});
+            }
+        }
+        ASSERT_EQUAL(server.GetDocumentCount(), fresh.GetDocumentCount());
+        for (const string& query : queries)
+        {
+            for (const auto& [actual, expected] : {
+                     pair{server.FindTopDocuments(query), fresh.FindTopDocuments(query)},
+                     pair{server.FindTopDocuments(std::execution::par, query, DocumentStatus::IRRELEVANT),
+                          fresh.FindTopDocuments(query, DocumentStatus::IRRELEVANT)},
+                     pair{server.FindTopDocuments(search_policy::max_score, query),
+                          fresh.FindTopDocuments(search_policy::max_score, query)}})
+            {
+                AssertSameDocuments(actual, expected);
+            }
+        }
+        for (int id = 0; id < static_cast<int>(texts.size()); id += 7)
+        {
+            ASSERT(server.GetWordFrequencies(id) == fresh.GetWordFrequencies(id));
+        }
+    };
+
+    SearchServer server(dictionary[0]);
+    for (int id = 0; id < static_cast<int>(texts.size()); ++id)
+    {
+        server.AddDocument(id, texts[id], static_cast<DocumentStatus>(id % 2), {id});
+    }
+
+    // Надгробий меньше порога очистки: документы только помечены
+    for (int id = 0; id < 3000; id += 3)
+    {
+        server.RemoveDocument(id);
+    }
+    check_same_as_fresh(server, [](int id) { return id % 3 == 0; });
+    bool is_thrown = false;
+    try
+    {
+        server.MatchDocument(queries[0], 3);
+    }
+    catch (const out_of_range&)
+    {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+
+    // Удалённых становится не меньше живых, и очистка запускается сама
+    for (int id = 1; id < 3000; id += 3)
+    {
+        server.RemoveDocument(std::execution::par, id);
+    }
+    check_same_as_fresh(server, [](int id) { return id % 3 != 2; });
+
+    // После очистки сервер продолжает принимать и удалять документы
+    server.AddDocument(3000, "уникальное слово"s, DocumentStatus::ACTUAL, {1});
+    server.RemoveDocument(5);
+    server.PurgeRemovedDocuments();
+    ASSERT_EQUAL(server.FindTopDocuments("уникальное"s).size(), 1u);
+    server.RemoveDocument(3000);
+    ASSERT(server.FindTopDocuments("уникальное"s).empty());
+    check_same_as_fresh(server, [](int id) { return id % 3 != 2 || id == 5; });
+
+    // Очистка выбрасывает из словаря слова без живых документов и нумерует оставшиеся подряд
+    SearchServer terms_server("и"s);
+    terms_server.AddDocument(1, "белый кот"s, DocumentStatus::ACTUAL, {1});
+    terms_server.AddDocument(2, "чёрный пёс"s, DocumentStatus::ACTUAL, {2});
+    terms_server.AddDocument(3, "белый и пёс"s, DocumentStatus::ACTUAL, {3});
+    terms_server.RemoveDocuments({1, 2});
+    vector<TermId> term_ids;
+    terms_server.GetDocumentTermIds(3, term_ids);
+    ASSERT((term_ids == vector<TermId>{0, 3}));
+    terms_server.PurgeRemovedDocuments();
+    terms_server.GetDocumentTermIds(3, term_ids);
+    ASSERT_HINT((term_ids == vector<TermId>{0, 1}), "Номера слов после очистки должны идти подряд"s);
+    ASSERT((terms_server.GetWordFrequencies(3) == map<string_view, double>{{"белый"sv, 0.5}, {"пёс"sv, 0.5}}));
+    ASSERT_EQUAL(terms_server.FindTopDocuments("кот белый"s).size(), 1u);
+    ASSERT(terms_server.FindTopDocuments("чёрный"s).empty());
+
+    // Выброшенное слово добавляется заново со следующим номером
+    terms_server.AddDocument(4, "кот"s, DocumentStatus::ACTUAL, {4});
+    terms_server.GetDocumentTermIds(4, term_ids);
+    ASSERT((term_ids == vector<TermId>{2}));
+    ASSERT_EQUAL(terms_server.FindTopDocuments("кот"s)[0].id, 4);
+}
+
+// Тестирование пакетного удаления документов
+void TestRemoveDocuments()
+{
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 300, 6);
+    vector<string> queries;
+    for (int i = 0; i < 50; ++i)
+    {
+        queries.push_back(GenerateQuery(generator, dictionary, 4, 0.2));
+    }
+    SearchServer initial(dictionary[0]);
+    for (int id = 0; id < 3000; ++id)
+    {
+        initial.AddDocument(id, GenerateQuery(generator, dictionary, 10, 0.0), static_cast<DocumentStatus>(id % 2), {id});
+    }
+    initial.AddDocument(3000, "уникальное слово"s, DocumentStatus::ACTUAL, {1});
+
+    // Пакетное удаление даёт то же состояние, что и удаление документов по одному
+    const auto check_batch = [&](const vector<int>& document_ids) {
+        SearchServer one_by_one = initial;
+        for (const int document_id : document_ids)
+        {
+            one_by_one.RemoveDocument(document_id);
+        }
+        SearchServer batch_seq = initial;
+        batch_seq.RemoveDocuments(document_ids);
+        SearchServer batch_par = initial;
+        batch_par.RemoveDocuments(std::execution::par, document_ids);
+
+        for (const SearchServer* server : {&batch_seq, &batch_par})
+        {
+            ASSERT_EQUAL(server->GetDocumentCount(), one_by_one.GetDocumentCount());
+            ASSERT(vector<int>(server->begin(), server->end()) == vector<int>(one_by_one.begin(), one_by_one.end()));
+            for (const string& query : queries)
+            {
+                const auto actual = server->FindTopDocuments(query);
+                const auto expected = one_by_one.FindTopDocuments(query);
+                AssertSameDocuments(actual, expected);
+            }
+            for (int id = 0; id < 3000; id += 7)
+            {
+                ASSERT(server->GetWordFrequencies(id) == one_by_one.GetWordFrequencies(id));
+            }
+        }
+    };
+
+    // Малый пакет с повторами и отсутствующими id: документы только помечаются
+    vector<int> small_batch{3000, 5, 5, -1, 100500};
+    for (int id = 0; id < 3000; id += 10)
+    {
+        small_batch.push_back(id);
+    }
+    check_batch(small_batch);
+    {
+        SearchServer server = initial;
+        server.RemoveDocuments(small_batch);
+        ASSERT(server.FindTopDocuments("уникальное"s).empty());
+        ASSERT_EQUAL(server.GetDocumentCount(), 3001 - 302);
+    }
+
+    // Большой пакет удаляет больше половины документов и переписывает списки одной очисткой
+    vector<int> large_batch;
+    for (int id = 2999; id >= 0; --id)
+    {
+        if (id % 3 != 2)
+        {
+            large_batch.push_back(id);
+        }
+    }
+    check_batch(large_batch);
+}
+
+void TestSearchServer() {
+    RUN_TEST(TestAddDocument);
+    RUN_TEST(TestExcludeStopWordsFromAddedDocumentContent);
+    RUN_TEST(TestMinusWords);
+    RUN_TEST(TestMatchDocument);
+    RUN_TEST(TestSortingByRelevance);
+    RUN_TEST(TestStatusPredicate);
+    RUN_TEST(TestAverageRating);
+    RUN_TEST(TestAnyPredicates);
+    RUN_TEST(TestRemoveDocument);
+    RUN_TEST(TestRemoveDuplicates);
+    RUN_TEST(TestRemoveNearDuplicates);
+    RUN_TEST(TestPostingList);
+    RUN_TEST(TestScoreAccumulator);
+    RUN_TEST(TestMaxResultCount);
+    RUN_TEST(TestMaxScorePolicy);
+    RUN_TEST(TestInverseDocumentFreqUpdates);
+    RUN_TEST(TestTermDictionary);
+    RUN_TEST(TestStopWordsOwnership);
+    RUN_TEST(TestAddDocuments);
+    RUN_TEST(TestSnapshot);
+    RUN_TEST(TestIngestCorpus);
+    RUN_TEST(TestSplitIntoWords);
+    RUN_TEST(TestParseQuery);
+    RUN_TEST(TestSmallVector);
+    RUN_TEST(TestStopWordFilter);
+    RUN_TEST(TestSearchContext);
+    RUN_TEST(TestQueryExecutor);
+    RUN_TEST(TestProcessQueriesJoined);
+    RUN_TEST(TestFindTopDocumentsAsync);
+    RUN_TEST(TestConcurrentSearchServer);
+    RUN_TEST(TestSegmentedSearchServer);
+    RUN_TEST(TestDeferredRemoval);
+    RUN_TEST(TestRemoveDocuments);
+}
+
+// --------- Окончание модульных тестов поисковой системы -----------
+
+
+// --------- Начало модульных тестов постраничной выдачи ------------
+
+// Функция проверяет правильность размера страницы при постраничном поиске
+void TestPageSize()
+{
+    {
+        SearchServer search_server("and with"s);
+        search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+        search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2, 3});
+        search_server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::ACTUAL, {1, 2, 8});
+        search_server.AddDocument(4, "big dog cat Vladislav"s, DocumentStatus::ACTUAL, {1, 3, 2});
+        search_server.AddDocument(5, "big dog hamster Borya"s, DocumentStatus::ACTUAL, {1, 1, 1});
+        
+        const auto search_results = search_server.FindTopDocuments("curly dog"s);
+        int page_size = 2;
+        
+        const auto pages = Paginate(search_results, page_size);
+        ASSERT_EQUAL_HINT(pages.size(), 
+                            static_cast<int>(ceil(search_results.size() * 1.0 / page_size)),
+                            "Количество страниц постраничного поиска некорректно"s);
+        
+        for (auto page = pages.begin(); page != pages.end(); ++page) {
+            if (page + 1 != pages.end())
+            {
+                ASSERT_EQUAL_HINT(page->size(), page_size, "Количество документов на странице некорректно"s); 
+            }
+            else {
+                ASSERT_EQUAL_HINT(page->size(), 
+                                    search_results.size() % page_size, 
+                                    "Количество документов последней страницы некорректно"s); 
+            }
+        }
+    }
+}
+
+// Функция проверяет, что ленивая постраничная выдача совпадает с выдачей по готовому результату
+void TestSearchPaginator()
+{
+    SearchServer search_server("and with"s);
+    for (int i = 0; i < 12; ++i)
+    {
+        search_server.AddDocument(i, "curly dog"s + string(i % 4, '!') + " and cat "s + to_string(i), 
+                                  i % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {i});
+    }
+    const int page_size = 3;
+    const auto any_document = [](int, DocumentStatus, int){ return true; };
+
+    const auto all_docs = search_server.FindTopDocuments(std::execution::seq, "curly cat"s, any_document, 100);
+    ASSERT_EQUAL(all_docs.size(), 12u);
+
+    const auto pages = Paginate(search_server, "curly cat"s, any_document, page_size);
+    size_t position = 0;
+    int page_count = 0;
+    for (const auto& page : pages)
+    {
+        ASSERT_HINT(!page.empty(), "Ленивая выдача не должна возвращать пустые страницы"s);
+        for (const Document& document : page)
+        {
+            ASSERT_EQUAL_HINT(document.id, all_docs[position].id, "Документы страницы не совпадают с полной выдачей"s);
+            ++position;
+        }
+        ++page_count;
+    }
+    ASSERT_EQUAL(position, all_docs.size());
+    ASSERT_EQUAL(page_count, 4);
+    ASSERT_HINT(pages.GetPage(4).empty(), "Страница за пределами выдачи должна быть пустой"s);
+    ASSERT_HINT(Paginate(search_server, "curly cat"s, any_document, 1'000'000).GetPage(10'000).empty(),
+                "Окно дальней страницы не должно переполнять int"s);
+
+    // Запомненная выдача отдаёт страницы в любом порядке
+    const auto fresh_pages = Paginate(search_server, "curly cat"s, any_document, page_size);
+    for (const int page_index : {2, 0, 3, 1})
+    {
+        const auto page = fresh_pages.GetPage(page_index);
+        ASSERT_EQUAL(page.size(), static_cast<size_t>(page_size));
+        for (int i = 0; i < page_size; ++i)
+        {
+            ASSERT_EQUAL(page[i].id, all_docs[page_index * page_size + i].id);
+        }
+    }
+
+    // По умолчанию выдача содержит только актуальные документы
+    size_t actual_count = 0;
+    for (const auto& page : Paginate(search_server, "curly cat"s, page_size))
+    {
+        ASSERT_HINT(static_cast<int>(page.size()) <= page_size, "Размер страницы превышает заданный"s);
+        actual_count += page.size();
+    }
+    ASSERT_EQUAL(actual_count, 9u);
+
+    // При множестве документов с равными релевантностью и рейтингом каждый документ
+    // попадает ровно на одну страницу при обходе смещениями любым способом поиска и пагинатором
+    mt19937 generator;
+    const auto dictionary = GenerateDictionary(generator, 30, 5);
+    SearchServer tied_server(dictionary[0]);
+    for (int id = 0; id < 2000; ++id)
+    {
+        tied_server.AddDocument(id, GenerateQuery(generator, dictionary, 4, 0.0), DocumentStatus::ACTUAL, {id % 3});
+    }
+    const auto assert_each_once = [](const vector<int>& ids, size_t expected_count) {
+        ASSERT_EQUAL(ids.size(), expected_count);
+        ASSERT_HINT(set<int>(ids.begin(), ids.end()).size() == ids.size(), "Документ попал на несколько страниц"s);
+    };
+    for (int i = 0; i < 20; ++i)
+    {
+        const string query = GenerateQuery(generator, dictionary, 2, 0.0);
+        const size_t found_count = tied_server.FindTopDocuments(std::execution::seq, query, any_document, 10'000).size();
+
+        vector<int> seq_ids;
+        vector<int> par_ids;
+        vector<int> max_score_ids;
+        for (int offset = 0; offset < static_cast<int>(found_count); offset += 10)
+        {
+            for (const Document& document : tied_server.FindTopDocuments(std::execution::seq, query, any_document, offset, 10))
+            {
+                seq_ids.push_back(document.id);
+            }
+            for (const Document& document : tied_server.FindTopDocuments(std::execution::par, query, any_document, offset, 10))
+            {
+                par_ids.push_back(document.id);
+            }
+            for (const Document& document : tied_server.FindTopDocuments(search_policy::max_score, query, any_document, offset, 10))
+            {
+                max_score_ids.push_back(document.id);
+            }
+        }
+        assert_each_once(seq_ids, found_count);
+        ASSERT(par_ids == seq_ids);
+        ASSERT(max_score_ids == seq_ids);
+
+        vector<int> paginated_ids;
+        for (const auto& page : Paginate(tied_server, query, any_document, 7))
+        {
+            for (const Document& document : page)
+            {
+                paginated_ids.push_back(document.id);
             }
         }
+        ASSERT(paginated_ids == seq_ids);
     }
 }
 
 void TestPaginator()
 {
     RUN_TEST(TestPageSize);
+    RUN_TEST(TestSearchPaginator);
 }
 // -------- Окончание модульных тестов постраничной выдачи ----------
 
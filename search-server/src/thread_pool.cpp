@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include "../include/thread_pool.h"
+
+using namespace std;
+
+namespace {
+
+// Пул и номер потока, которому принадлежит текущий поток
+struct WorkerIdentity {
+    const ThreadPool* pool = nullptr;
+    size_t index = 0;
+};
+
+thread_local WorkerIdentity current_worker;
+
+}
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+    thread_count = max<size_t>(thread_count, 1);
+    queues_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        queues_.push_back(make_unique<WorkerQueue>());
+    }
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+    {
+        threads_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard guard(sleep_mutex_);
+        is_stopping_ = true;
+    }
+    wake_up_.notify_all();
+    for (thread& worker : threads_)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(function<void()> task)
+{
+    // Задача потока пула остаётся в его очереди, внешние задачи распределяются по кругу
+    size_t queue_index = GetWorkerIndex();
+    if (queue_index == NOT_A_WORKER)
+    {
+        queue_index = next_queue_.fetch_add(1, memory_order_relaxed) % queues_.size();
+    }
+    // Счётчик увеличивается до постановки в очередь: иначе перехвативший задачу поток мог бы
+    // уменьшить его раньше и на мгновение переполнить вниз
+    pending_count_.fetch_add(1);
+    try
+    {
+        lock_guard guard(queues_[queue_index]->mutex);
+        queues_[queue_index]->tasks.push_back(move(task));
+    }
+    catch (...)
+    {
+        pending_count_.fetch_sub(1);
+        throw;
+    }
+    {
+        // Захват мьютекса упорядочивает уведомление с проверкой условия спящим потоком
+        lock_guard guard(sleep_mutex_);
+    }
+    wake_up_.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count, const function<void(size_t)>& func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // Помощник, запущенный после разбора всех итераций, не обращается к func:
+    // вызов к этому моменту мог уже завершиться
+    struct SharedState {
+        const function<void(size_t)>* func = nullptr;
+        size_t count = 0;
+        atomic<size_t> next_index{0};
+        size_t remaining = 0;
+        mutex finish_mutex;
+        condition_variable finished;
+        exception_ptr error;
+    };
+    const auto state = make_shared<SharedState>();
+    state->func = &func;
+    state->count = count;
+    state->remaining = count;
+
+    const auto run_iterations = [](SharedState& state) {
+        while (true)
+        {
+            const size_t i = state.next_index.fetch_add(1, memory_order_relaxed);
+            if (i >= state.count)
+            {
+                return;
+            }
+            exception_ptr error;
+            try
+            {
+                (*state.func)(i);
+            }
+            catch (...)
+            {
+                error = current_exception();
+            }
+            lock_guard guard(state.finish_mutex);
+            if (error && !state.error)
+            {
+                state.error = error;
+            }
+            if (--state.remaining == 0)
+            {
+                state.finished.notify_all();
+            }
+        }
+    };
+
+    const size_t helper_count = min(count - 1, GetThreadCount());
+    for (size_t i = 0; i < helper_count; ++i)
+    {
+        Submit([state, run_iterations] { run_iterations(*state); });
+    }
+    run_iterations(*state);
+
+    unique_lock lock(state->finish_mutex);
+    state->finished.wait(lock, [&state] { return state->remaining == 0; });
+    if (state->error)
+    {
+        rethrow_exception(state->error);
+    }
+}
+
+size_t ThreadPool::GetWorkerIndex() const
+{
+    return current_worker.pool == this ? current_worker.index : NOT_A_WORKER;
+}
+
+bool ThreadPool::TryRunTask(size_t worker_index)
+{
+    function<void()> task;
+
+    if (worker_index != NOT_A_WORKER)
+    {
+        WorkerQueue& own_queue = *queues_[worker_index];
+        lock_guard guard(own_queue.mutex);
+        if (!own_queue.tasks.empty())
+        {
+            task = move(own_queue.tasks.back());
+            own_queue.tasks.pop_back();
+        }
+    }
+
+    const size_t first_victim = worker_index == NOT_A_WORKER ? 0 : worker_index + 1;
+    for (size_t i = 0; !task && i < queues_.size(); ++i)
+    {
+        WorkerQueue& victim_queue = *queues_[(first_victim + i) % queues_.size()];
+        lock_guard guard(victim_queue.mutex);
+        if (!victim_queue.tasks.empty())
+        {
+            task = move(victim_queue.tasks.front());
+            victim_queue.tasks.pop_front();
+        }
+    }
+
+    if (!task)
+    {
+        return false;
+    }
+    pending_count_.fetch_sub(1);
+    task();
+    return true;
+}
+
+void ThreadPool::WorkerLoop(size_t worker_index)
+{
+    current_worker = {this, worker_index};
+    while (true)
+    {
+        if (TryRunTask(worker_index))
+        {
+            continue;
+        }
+
+        unique_lock lock(sleep_mutex_);
+        wake_up_.wait(lock, [this] { return is_stopping_ || pending_count_.load() > 0; });
+        if (is_stopping_ && pending_count_.load() == 0)
+        {
+            return;
+        }
+    }
+}